@@ -0,0 +1,39 @@
+// Replaces the global operator new so heapAllocationCount sees every heap
+// allocation made through the standard containers. Linked into
+// particle_simulation and particle_soak; libparticle_sim leaves the host's
+// allocator alone and does not expose the count.
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include "frame_arena.h"
+
+void* operator new(std::size_t bytes) {
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(bytes ? bytes : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t bytes, std::align_val_t align) {
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    size_t a = static_cast<size_t>(align);
+    // aligned_alloc wants a multiple of the alignment
+    if (void* p = std::aligned_alloc(a, (std::max<size_t>(bytes, 1) + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,552 @@
+#include "collision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "event_log.h"
+#include "parallel.h"
+#include "simulation.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PARTICLE_SIM_AVX2 1
+#include <immintrin.h>
+#endif
+
+// Minimum distance used in place of zero so coincident centres do not produce NaNs
+static const float MIN_DIST_SQ = 1e-6f;
+
+int UniformGrid::cellX(float x) const {
+    int c = static_cast<int>((x - originX) / cellSize);
+    return std::clamp(c, 0, cols - 1);
+}
+
+int UniformGrid::cellY(float y) const {
+    int c = static_cast<int>((y - originY) / cellSize);
+    return std::clamp(c, 0, rows - 1);
+}
+
+void UniformGrid::build(const std::vector<Particle>& particles) {
+    float maxSize = 1.0f;
+    for (const auto& p : particles) maxSize = std::max(maxSize, p.size);
+
+    cellSize = 2.0f * maxSize;
+    originX = 0.0f;
+    originY = 0.0f;
+    cols = std::max(1, static_cast<int>(std::ceil(WINDOW_WIDTH / cellSize)));
+    rows = std::max(1, static_cast<int>(std::ceil(WINDOW_HEIGHT / cellSize)));
+
+    size_t cells = static_cast<size_t>(cols) * rows;
+    cellStart.assign(cells + 1, 0);
+    cellOf.resize(particles.size());
+    indices.resize(particles.size());
+
+    // Counting sort keeps particles of one cell contiguous and in index order
+    for (size_t i = 0; i < particles.size(); ++i) {
+        uint32_t c = static_cast<uint32_t>(cellY(particles[i].y) * cols + cellX(particles[i].x));
+        cellOf[i] = c;
+        cellStart[c + 1]++;
+    }
+    for (size_t c = 0; c < cells; ++c) cellStart[c + 1] += cellStart[c];
+    for (size_t i = 0; i < particles.size(); ++i) {
+        indices[cellStart[cellOf[i]]++] = static_cast<uint32_t>(i);
+    }
+    // The scatter advanced every start to the next cell's; shift them back
+    for (size_t c = cells; c > 0; --c) cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+}
+
+void ContactBatch::resize(size_t n) {
+    for (auto* v : {&ax, &ay, &avx, &avy, &as, &bx, &by, &bvx, &bvy, &bs, &elastic,
+                    &dav_x, &dav_y, &dbv_x, &dbv_y, &sep_x, &sep_y}) {
+        v->resize(n);
+    }
+}
+
+int LooseQuadtree::nodeX(int depth, float x) const {
+    // max before min so a NaN position lands in the first node
+    const Level& l = levels[depth];
+    return static_cast<int>(std::min(std::max(0.0f, x / l.cellSize), static_cast<float>(l.cols - 1)));
+}
+
+int LooseQuadtree::nodeY(int depth, float y) const {
+    const Level& l = levels[depth];
+    return static_cast<int>(std::min(std::max(0.0f, y / l.cellSize), static_cast<float>(l.rows - 1)));
+}
+
+uint32_t LooseQuadtree::place(const Particle& p) const {
+    int depth = DEPTHS - 1;
+    while (depth > 0 && levels[depth].cellSize < 2.0f * p.size) depth--;
+    uint32_t node = static_cast<uint32_t>(nodeY(depth, p.y) * levels[depth].cols + nodeX(depth, p.x));
+    return static_cast<uint32_t>(depth) << 24 | node;
+}
+
+void LooseQuadtree::insert(uint32_t i, uint32_t key) {
+    Level& l = levels[key >> 24];
+    l.nodes[key & 0xFFFFFF].push_back(i);
+    l.population++;
+}
+
+void LooseQuadtree::erase(uint32_t i, uint32_t key) {
+    Level& l = levels[key >> 24];
+    std::vector<uint32_t>& node = l.nodes[key & 0xFFFFFF];
+    auto it = std::find(node.begin(), node.end(), i);
+    *it = node.back();
+    node.pop_back();
+    l.population--;
+}
+
+void LooseQuadtree::update(World& w) {
+    const std::vector<Particle>& particles = w.particles;
+    if (levels[0].nodes.empty()) {
+        for (int d = 0; d < DEPTHS; ++d) {
+            Level& l = levels[d];
+            l.cellSize = ROOT_SIZE / static_cast<float>(1 << d);
+            l.cols = std::max(1, static_cast<int>(std::ceil(WINDOW_WIDTH / l.cellSize)));
+            l.rows = std::max(1, static_cast<int>(std::ceil(WINDOW_HEIGHT / l.cellSize)));
+            l.nodes.resize(static_cast<size_t>(l.cols) * l.rows);
+        }
+    }
+
+    // Place every particle and note the ones that left their node
+    size_t n = particles.size();
+    size_t kept = std::min(n, nodeOf.size());
+    size_t chunks = chunkCount(n);
+    if (moved.size() < chunks) moved.resize(chunks);
+    reordered.assign(chunks, 0);
+    placed.resize(n);
+    parallelFor(w.pool, n, [&](size_t begin, size_t end, size_t c) {
+        moved[c].clear();
+        for (size_t i = begin; i < end; ++i) {
+            placed[i] = place(particles[i]);
+            if (i >= kept) continue;
+            if (ids[i] != particles[i].id) reordered[c] = 1;
+            else if (placed[i] != nodeOf[i]) moved[c].push_back(static_cast<uint32_t>(i));
+        }
+    });
+
+    bool rebuild = n < nodeOf.size() || std::find(reordered.begin(), reordered.end(), 1) != reordered.end();
+    if (rebuild) {
+        for (Level& l : levels) {
+            for (auto& node : l.nodes) node.clear();
+            l.population = 0;
+        }
+        for (size_t i = 0; i < n; ++i) insert(static_cast<uint32_t>(i), placed[i]);
+        rebuilds++;
+    } else {
+        for (size_t c = 0; c < chunks; ++c) {
+            for (uint32_t i : moved[c]) {
+                erase(i, nodeOf[i]);
+                insert(i, placed[i]);
+            }
+            moves += moved[c].size();
+        }
+        for (size_t i = kept; i < n; ++i) insert(static_cast<uint32_t>(i), placed[i]);
+    }
+    nodeOf.swap(placed);
+    ids.resize(n);
+    for (size_t i = rebuild ? 0 : kept; i < n; ++i) ids[i] = particles[i].id;
+}
+
+// Calls fn(j) for every particle in the 3x3 nodes around (x, y) at depth
+template <typename Fn>
+static void forNeighbourNodes(const LooseQuadtree& tree, int depth, float x, float y, Fn&& fn) {
+    const LooseQuadtree::Level& l = tree.levels[depth];
+    int cx = tree.nodeX(depth, x);
+    int cy = tree.nodeY(depth, y);
+    for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, l.rows - 1); ++ny) {
+        for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, l.cols - 1); ++nx) {
+            for (uint32_t j : l.nodes[static_cast<size_t>(ny) * l.cols + nx]) fn(j);
+        }
+    }
+}
+
+static void findContactsQuadtree(World& w) {
+    const std::vector<Particle>& particles = w.particles;
+    LooseQuadtree& tree = w.quadtree;
+    tree.update(w);
+
+    parallelFor(w.pool, particles.size(), [&](size_t begin, size_t end, size_t c) {
+        std::vector<Contact>& local = w.contactChunks[c];
+        local.clear();
+        for (size_t i = begin; i < end; ++i) {
+            // Pairs at one depth are found as in the grid; a pair across
+            // depths only by its deeper (smaller) particle, which searches
+            // shallower depths even when asleep, for awake partners
+            const Particle& a = particles[i];
+            uint32_t self = static_cast<uint32_t>(i);
+            int depth = static_cast<int>(tree.nodeOf[i] >> 24);
+            size_t first = local.size();
+            auto test = [&](uint32_t j) {
+                const Particle& b = particles[j];
+                float dx = b.x - a.x;
+                float dy = b.y - a.y;
+                float minDist = a.size + b.size;
+                if (dx * dx + dy * dy < minDist * minDist) local.push_back(j > self ? Contact{self, j} : Contact{j, self});
+            };
+            if (!a.asleep) {
+                forNeighbourNodes(tree, depth, a.x, a.y, [&](uint32_t j) {
+                    if (j == i || (j < i && !particles[j].asleep)) return;
+                    test(j);
+                });
+            }
+            for (int d = depth - 1; d >= 0; --d) {
+                if (tree.levels[d].population == 0) continue;
+                forNeighbourNodes(tree, d, a.x, a.y, [&](uint32_t j) {
+                    if (a.asleep && particles[j].asleep) return;
+                    test(j);
+                });
+            }
+            // Node contents are in no particular order; partner order keeps the list deterministic
+            std::sort(local.begin() + first, local.end(), [self](const Contact& x, const Contact& y) {
+                return (x.a == self ? x.b : x.a) < (y.a == self ? y.b : y.a);
+            });
+        }
+    });
+}
+
+static void findContactsGrid(World& w) {
+    const std::vector<Particle>& particles = w.particles;
+    UniformGrid& grid = w.grid;
+    grid.build(particles);
+
+    parallelFor(w.pool, particles.size(), [&](size_t begin, size_t end, size_t c) {
+        std::vector<Contact>& local = w.contactChunks[c];
+        local.clear();
+        for (size_t i = begin; i < end; ++i) {
+            // Awake particles search for contacts in both directions; a pair of
+            // awake particles is kept from its lower index, sleepers never search
+            const Particle& a = particles[i];
+            if (a.asleep) continue;
+            int cx = static_cast<int>(grid.cellOf[i] % grid.cols);
+            int cy = static_cast<int>(grid.cellOf[i] / grid.cols);
+            for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, grid.rows - 1); ++y) {
+                for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, grid.cols - 1); ++x) {
+                    size_t cell = static_cast<size_t>(y) * grid.cols + x;
+                    for (uint32_t k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; ++k) {
+                        uint32_t j = grid.indices[k];
+                        if (j == i || (j < i && !particles[j].asleep)) continue;
+                        const Particle& b = particles[j];
+                        float dx = b.x - a.x;
+                        float dy = b.y - a.y;
+                        float minDist = a.size + b.size;
+                        if (dx * dx + dy * dy < minDist * minDist) {
+                            uint32_t self = static_cast<uint32_t>(i);
+                            local.push_back(j > self ? Contact{self, j} : Contact{j, self});
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+void findContacts(World& w, std::vector<Contact>& out) {
+    size_t chunks = chunkCount(w.particles.size());
+    if (w.contactChunks.size() < chunks) w.contactChunks.resize(chunks);
+    if (w.broadPhase == BroadPhase::Quadtree) findContactsQuadtree(w);
+    else findContactsGrid(w);
+
+    out.clear();
+    for (size_t c = 0; c < chunks; ++c) {
+        out.insert(out.end(), w.contactChunks[c].begin(), w.contactChunks[c].end());
+    }
+}
+
+// Scalar and AVX2 kernels perform the same IEEE operations in the same order
+// (no FMA contraction), so both paths give bitwise identical results.
+void contactKernelScalar(ContactBatch& batch, size_t begin, size_t n) {
+    for (size_t k = begin; k < n; ++k) {
+        float cx = batch.ax[k] - batch.bx[k];
+        float cy = batch.ay[k] - batch.by[k];
+        float distSq = std::max(cx * cx + cy * cy, MIN_DIST_SQ);
+        float rc = (batch.avx[k] - batch.bvx[k]) * cx + (batch.avy[k] - batch.bvy[k]) * cy;
+        float s = rc / distSq;
+        float total = batch.as[k] + batch.bs[k];
+
+        // m1 * vi1 + m2 * vi2 = (m1 + m2) * vf
+        float ka = batch.elastic[k] != 0.0f ? ((2.0f * batch.bs[k]) / total) * s : 0.0f;
+        float kb = batch.elastic[k] != 0.0f ? ((2.0f * batch.as[k]) / total) * s : 0.0f;
+        batch.dav_x[k] = -(ka * cx);
+        batch.dav_y[k] = -(ka * cy);
+        batch.dbv_x[k] = kb * cx;
+        batch.dbv_y[k] = kb * cy;
+
+        // Separate overlapping particles along the normal from a to b
+        float dist = std::sqrt(distSq);
+        float overlap = 0.5f * (total - dist + 1.0f);
+        batch.sep_x[k] = -(cx / dist) * overlap;
+        batch.sep_y[k] = -(cy / dist) * overlap;
+    }
+}
+
+#ifdef PARTICLE_SIM_AVX2
+__attribute__((target("avx2")))
+static size_t contactKernelAvx2(ContactBatch& batch, size_t n) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 minDistSq = _mm256_set1_ps(MIN_DIST_SQ);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256 ax = _mm256_loadu_ps(&batch.ax[k]);
+        __m256 ay = _mm256_loadu_ps(&batch.ay[k]);
+        __m256 bx = _mm256_loadu_ps(&batch.bx[k]);
+        __m256 by = _mm256_loadu_ps(&batch.by[k]);
+        __m256 as = _mm256_loadu_ps(&batch.as[k]);
+        __m256 bs = _mm256_loadu_ps(&batch.bs[k]);
+        __m256 elastic = _mm256_cmp_ps(_mm256_loadu_ps(&batch.elastic[k]), zero, _CMP_NEQ_OQ);
+
+        __m256 cx = _mm256_sub_ps(ax, bx);
+        __m256 cy = _mm256_sub_ps(ay, by);
+        __m256 distSq = _mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)), minDistSq);
+        __m256 rvx = _mm256_sub_ps(_mm256_loadu_ps(&batch.avx[k]), _mm256_loadu_ps(&batch.bvx[k]));
+        __m256 rvy = _mm256_sub_ps(_mm256_loadu_ps(&batch.avy[k]), _mm256_loadu_ps(&batch.bvy[k]));
+        __m256 rc = _mm256_add_ps(_mm256_mul_ps(rvx, cx), _mm256_mul_ps(rvy, cy));
+        __m256 s = _mm256_div_ps(rc, distSq);
+        __m256 total = _mm256_add_ps(as, bs);
+
+        __m256 ka = _mm256_and_ps(_mm256_mul_ps(_mm256_div_ps(_mm256_mul_ps(two, bs), total), s), elastic);
+        __m256 kb = _mm256_and_ps(_mm256_mul_ps(_mm256_div_ps(_mm256_mul_ps(two, as), total), s), elastic);
+        _mm256_storeu_ps(&batch.dav_x[k], _mm256_xor_ps(_mm256_mul_ps(ka, cx), signMask));
+        _mm256_storeu_ps(&batch.dav_y[k], _mm256_xor_ps(_mm256_mul_ps(ka, cy), signMask));
+        _mm256_storeu_ps(&batch.dbv_x[k], _mm256_mul_ps(kb, cx));
+        _mm256_storeu_ps(&batch.dbv_y[k], _mm256_mul_ps(kb, cy));
+
+        __m256 dist = _mm256_sqrt_ps(distSq);
+        __m256 overlap = _mm256_mul_ps(half, _mm256_add_ps(_mm256_sub_ps(total, dist), one));
+        _mm256_storeu_ps(&batch.sep_x[k], _mm256_mul_ps(_mm256_xor_ps(_mm256_div_ps(cx, dist), signMask), overlap));
+        _mm256_storeu_ps(&batch.sep_y[k], _mm256_mul_ps(_mm256_xor_ps(_mm256_div_ps(cy, dist), signMask), overlap));
+    }
+    return k;
+}
+#endif
+
+bool contactKernelUsesAvx2() {
+#ifdef PARTICLE_SIM_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+void contactKernel(ContactBatch& batch, size_t n) {
+    size_t done = 0;
+#ifdef PARTICLE_SIM_AVX2
+    if (contactKernelUsesAvx2()) done = contactKernelAvx2(batch, n);
+#endif
+    contactKernelScalar(batch, done, n);
+}
+
+static void atomicMin(std::atomic<uint64_t>& slot, uint64_t v) {
+    uint64_t cur = slot.load(std::memory_order_relaxed);
+    while (v < cur && !slot.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+}
+
+// Appends the per-chunk lists to out in chunk order
+static void concatChunks(std::vector<std::vector<ReactionScratch::Candidate>>& chunks, size_t count,
+                         std::vector<ReactionScratch::Candidate>& out) {
+    out.clear();
+    for (size_t c = 0; c < count; ++c) out.insert(out.end(), chunks[c].begin(), chunks[c].end());
+}
+
+void reactContacts(World& w, const std::vector<Contact>& contacts) {
+    using Candidate = ReactionScratch::Candidate;
+    ReactionScratch& r = w.reactions;
+    const std::vector<Particle>& particles = w.particles;
+    r.consumed.clear();
+
+    // Gather reactive pairs; the key orders them by overlap depth, then contact index
+    size_t chunks = chunkCount(contacts.size());
+    if (r.chunks.size() < chunks) r.chunks.resize(chunks);
+    parallelFor(w.pool, contacts.size(), [&](size_t begin, size_t end, size_t c) {
+        std::vector<Candidate>& local = r.chunks[c];
+        local.clear();
+        for (size_t k = begin; k < end; ++k) {
+            const Particle& a = particles[contacts[k].a];
+            const Particle& b = particles[contacts[k].b];
+            if (a.merged || b.merged || a.frozen || b.frozen) continue;
+            uint16_t product = reactionProduct(a.species, b.species);
+            if (product == UNKNOWN_SPECIES) continue;
+
+            float dx = b.x - a.x;
+            float dy = b.y - a.y;
+            float depth = a.size + b.size - std::sqrt(dx * dx + dy * dy);
+            if (!(depth >= 0.0f)) depth = 0.0f;
+            uint32_t bits;
+            std::memcpy(&bits, &depth, sizeof(bits));
+            // Positive floats order like their bit patterns; the key is never 0
+            uint64_t key = static_cast<uint64_t>(~bits) << 32 | static_cast<uint32_t>(k);
+            local.push_back({contacts[k].a, contacts[k].b, key, product});
+        }
+    });
+    concatChunks(r.chunks, chunks, r.candidates);
+    if (r.candidates.empty()) return;
+
+    if (r.bestSize < particles.size()) {
+        r.bestSize = particles.size();
+        r.best.reset(new std::atomic<uint64_t>[r.bestSize]);
+    }
+    const uint64_t TAKEN = 0;
+
+    // Matching rounds: a candidate that is the lowest key at both of its
+    // particles is taken and moved to candidates; candidates touching a taken
+    // particle drop out
+    r.live = r.candidates;
+    r.candidates.clear();
+    while (!r.live.empty()) {
+        size_t liveChunks = chunkCount(r.live.size());
+        if (r.chunks.size() < liveChunks) r.chunks.resize(liveChunks);
+        parallelFor(w.pool, r.live.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t k = begin; k < end; ++k) {
+                r.best[r.live[k].a].store(UINT64_MAX, std::memory_order_relaxed);
+                r.best[r.live[k].b].store(UINT64_MAX, std::memory_order_relaxed);
+            }
+        });
+        parallelFor(w.pool, r.live.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t k = begin; k < end; ++k) {
+                atomicMin(r.best[r.live[k].a], r.live[k].key);
+                atomicMin(r.best[r.live[k].b], r.live[k].key);
+            }
+        });
+        parallelFor(w.pool, r.live.size(), [&](size_t begin, size_t end, size_t c) {
+            std::vector<Candidate>& local = r.chunks[c];
+            local.clear();
+            for (size_t k = begin; k < end; ++k) {
+                const Candidate& e = r.live[k];
+                if (r.best[e.a].load(std::memory_order_relaxed) == e.key &&
+                    r.best[e.b].load(std::memory_order_relaxed) == e.key) {
+                    local.push_back(e);
+                }
+            }
+        });
+        for (size_t c = 0; c < liveChunks; ++c) {
+            for (const Candidate& e : r.chunks[c]) {
+                r.best[e.a].store(TAKEN, std::memory_order_relaxed);
+                r.best[e.b].store(TAKEN, std::memory_order_relaxed);
+                r.candidates.push_back(e);
+            }
+        }
+        parallelFor(w.pool, r.live.size(), [&](size_t begin, size_t end, size_t c) {
+            std::vector<Candidate>& local = r.chunks[c];
+            local.clear();
+            for (size_t k = begin; k < end; ++k) {
+                const Candidate& e = r.live[k];
+                if (r.best[e.a].load(std::memory_order_relaxed) != TAKEN &&
+                    r.best[e.b].load(std::memory_order_relaxed) != TAKEN) {
+                    local.push_back(e);
+                }
+            }
+        });
+        concatChunks(r.chunks, liveChunks, r.live);
+    }
+
+    // Merges run in contact order: products are built in parallel, then
+    // counted, logged and given their heat serially
+    std::sort(r.candidates.begin(), r.candidates.end(), [](const Candidate& x, const Candidate& y) {
+        return static_cast<uint32_t>(x.key) < static_cast<uint32_t>(y.key);
+    });
+    r.consumed.assign(particles.size(), 0);
+    size_t first = w.spawned.size();
+    w.spawned.resize(first + r.candidates.size());
+    uint32_t firstId = w.nextId;
+    w.nextId += static_cast<uint32_t>(r.candidates.size());
+    parallelFor(w.pool, r.candidates.size(), [&](size_t begin, size_t end, size_t) {
+        for (size_t k = begin; k < end; ++k) {
+            const Candidate& e = r.candidates[k];
+            w.spawned[first + k] = makeProduct(particles[e.a], particles[e.b], e.product,
+                                               firstId + static_cast<uint32_t>(k), w.step);
+            r.consumed[e.a] = 1;
+            r.consumed[e.b] = 1;
+        }
+    });
+    for (size_t k = 0; k < r.candidates.size(); ++k) {
+        const Candidate& e = r.candidates[k];
+        recordMerge(w, particles[e.a], particles[e.b], w.spawned[first + k]);
+    }
+}
+
+// Contacts are staged in blocks so the batch stays cache-sized however dense the scene is
+static const size_t CONTACT_BLOCK = 1024;
+
+void resolveContacts(World& w, const std::vector<Contact>& contacts) {
+    std::vector<Particle>& particles = w.particles;
+    ContactBatch& batch = w.batch;
+    batch.resize(CONTACT_BLOCK);
+
+    reactContacts(w, contacts);
+    const std::vector<uint8_t>& consumed = w.reactions.consumed;
+
+    for (size_t first = 0; first < contacts.size(); first += CONTACT_BLOCK) {
+        size_t n = std::min(CONTACT_BLOCK, contacts.size() - first);
+        const Contact* block = contacts.data() + first;
+
+        // Gather into the kernel's staging arrays. After the reaction stage every
+        // contact left with a reactive pair has a consumed particle, so the
+        // elastic flag just marks contacts that still exist. Earlier blocks
+        // have moved particles since the broad phase, so a pair they pushed
+        // apart is dropped here, as the per-pair response did.
+        for (size_t k = 0; k < n; ++k) {
+            Particle& a = particles[block[k].a];
+            Particle& b = particles[block[k].b];
+            float dx = b.x - a.x;
+            float dy = b.y - a.y;
+            float minDist = a.size + b.size;
+            bool consumedPair = !consumed.empty() && (consumed[block[k].a] || consumed[block[k].b]);
+            bool apart = !consumedPair && dx * dx + dy * dy >= minDist * minDist;
+            if (!apart) {
+                eventLog.collision(w.step, a.id, b.id);
+                if (a.asleep) wakeParticle(a);
+                if (b.asleep) wakeParticle(b);
+            }
+
+            batch.ax[k] = a.x;
+            batch.ay[k] = a.y;
+            batch.avx[k] = a.vx;
+            batch.avy[k] = a.vy;
+            batch.as[k] = a.size;
+            batch.bx[k] = b.x;
+            batch.by[k] = b.y;
+            batch.bvx[k] = b.vx;
+            batch.bvy[k] = b.vy;
+            batch.bs[k] = b.size;
+            batch.elastic[k] = consumedPair || apart ? 0.0f : 1.0f;
+        }
+
+        // Stage 3: response for the whole block at once
+        contactKernel(batch, n);
+
+        // Scatter in contact order; a particle in several contacts accumulates them all
+        for (size_t k = 0; k < n; ++k) {
+            Particle& a = particles[block[k].a];
+            Particle& b = particles[block[k].b];
+            // Consumed particles are removed after this pass and push nothing;
+            // separated pairs neither push nor exchange momentum
+            if (batch.elastic[k] == 0.0f) continue;
+            // Frozen particles act as fixed obstacles
+            if (!a.frozen) {
+                a.init_vx += batch.dav_x[k];
+                a.init_vy += batch.dav_y[k];
+                a.vx -= 0.01;
+                a.vy -= 0.01;
+            }
+            if (!b.frozen) {
+                b.init_vx += batch.dbv_x[k];
+                b.init_vy += batch.dbv_y[k];
+                b.vx -= 0.01;
+                b.vy -= 0.01;
+            }
+            if (!a.frozen) {
+                a.x -= batch.sep_x[k];
+                a.y -= batch.sep_y[k];
+            }
+            if (!b.frozen) {
+                b.x += batch.sep_x[k];
+                b.y += batch.sep_y[k];
+            }
+        }
+    }
+}
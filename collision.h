@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct Particle;
+struct World;
+
+// Collision handling runs in three stages:
+//   1. broad phase: a uniform grid or a loose quadtree (World::broadPhase)
+//      yields candidate pairs, which are tested for overlap and compacted into
+//      a contact list
+//   2. reaction stage: reactive pairs are gathered in parallel, a deterministic
+//      maximal matching picks a set in which every particle reacts at most
+//      once, and the chosen merges are built in bulk; their inputs are consumed
+//   3. narrow phase: elastic response and positional separation, computed by a
+//      vectorised kernel over blocks of contacts and applied in contact order
+
+struct Contact {
+    uint32_t a, b;  // Particle indices, a < b
+};
+
+// Particle indices bucketed by cell with a counting sort. Cells are at least
+// as wide as the largest particle diameter, so overlapping particles are
+// always in the same or adjacent cells.
+struct UniformGrid {
+    float cellSize = 1.0f;
+    float originX = 0.0f;
+    float originY = 0.0f;
+    int cols = 0;
+    int rows = 0;
+    std::vector<uint32_t> cellStart;  // cols * rows + 1 offsets into indices
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> cellOf;     // Cell of each particle
+
+    void build(const std::vector<Particle>& particles);
+
+    int cellX(float x) const;
+    int cellY(float y) const;
+};
+
+enum class BroadPhase { Grid, Quadtree };
+
+// Broad phase for particles of very different sizes. Depth d splits the
+// window into square cells of ROOT_SIZE / 2^d pixels; a particle is stored at
+// the deepest depth whose cell is at least its diameter, in the node holding
+// its centre, so it lies within the node's loose bounds (the cell grown by
+// half a cell on each side). Each depth is a flat array of nodes. Particles
+// at one depth that overlap sit in neighbouring nodes, and a particle meets
+// every larger one in the 3x3 nodes around its centre at each shallower
+// depth: small particles never scan cells sized for giants, and giants never
+// span many cells. Between steps only particles that changed node are moved;
+// a reordered particle list (removals) is rebuilt from scratch.
+struct LooseQuadtree {
+    static const int DEPTHS = 8;
+    static constexpr float ROOT_SIZE = 2048.0f;  // Covers the window, so depth 0 is one node
+
+    struct Level {
+        float cellSize = 0.0f;
+        int cols = 0;
+        int rows = 0;
+        size_t population = 0;
+        std::vector<std::vector<uint32_t>> nodes;  // Particle indices, in no particular order
+    };
+    Level levels[DEPTHS];
+    std::vector<uint32_t> nodeOf;  // Per particle: depth << 24 | node
+    std::vector<uint32_t> ids;     // Particle ids the nodes were filled with
+    std::vector<uint32_t> placed;  // Scratch: this step's node per particle
+    std::vector<std::vector<uint32_t>> moved;
+    std::vector<uint8_t> reordered;
+    uint64_t rebuilds = 0;         // Full rebuilds and single-particle moves so far
+    uint64_t moves = 0;
+
+    void update(World& w);
+    uint32_t place(const Particle& p) const;
+    int nodeX(int depth, float x) const;
+    int nodeY(int depth, float y) const;
+
+private:
+    void insert(uint32_t i, uint32_t key);
+    void erase(uint32_t i, uint32_t key);
+};
+
+// Structure-of-arrays staging for the narrow-phase kernel
+struct ContactBatch {
+    std::vector<float> ax, ay, avx, avy, as;
+    std::vector<float> bx, by, bvx, bvy, bs;
+    std::vector<float> elastic;           // 1 for bouncing pairs, 0 for reacting pairs
+    std::vector<float> dav_x, dav_y;      // Change of a.init_vx/vy
+    std::vector<float> dbv_x, dbv_y;      // Change of b.init_vx/vy
+    std::vector<float> sep_x, sep_y;      // a moves by -sep, b by +sep
+
+    void resize(size_t n);
+};
+
+// Scratch of the reaction stage, kept across steps
+struct ReactionScratch {
+    struct Candidate {
+        uint32_t a, b;     // Particle indices
+        uint64_t key;      // Lower wins: deeper overlap first, then contact order
+        uint16_t product;
+    };
+    std::vector<Candidate> candidates;  // Reactive contacts, later the matched ones
+    std::vector<Candidate> live;        // Still unmatched with both ends free
+    std::vector<std::vector<Candidate>> chunks;
+    std::unique_ptr<std::atomic<uint64_t>[]> best;  // Per particle: lowest live key, or 0 once matched
+    size_t bestSize = 0;
+    std::vector<uint8_t> consumed;      // Per particle, 1 for this step's merge inputs; empty when none
+};
+
+// Stage 1: overlapping pairs, each with a < b, ordered by the awake particle
+// that found them (the smaller one across quadtree depths, then by partner
+// index); pairs of two sleeping particles are skipped
+void findContacts(World& w, std::vector<Contact>& out);
+
+// Stage 2: merges a conflict-free set of the reacting contacts. The set is
+// what a serial greedy pass in key order would pick (each round takes every
+// candidate that is the best of both its particles), so it does not depend on
+// the thread count. Products are appended to w.spawned and their inputs
+// flagged in w.reactions.consumed; the caller removes them.
+void reactContacts(World& w, const std::vector<Contact>& contacts);
+
+// Stages 2 and 3 for the contacts of this step; contacts of consumed particles get no response
+void resolveContacts(World& w, const std::vector<Contact>& contacts);
+
+// Narrow-phase kernel over batch entries [0, n); exposed for the scalar/SIMD comparison
+void contactKernel(ContactBatch& batch, size_t n);
+void contactKernelScalar(ContactBatch& batch, size_t begin, size_t n);
+bool contactKernelUsesAvx2();
@@ -0,0 +1,273 @@
+#include "compact.h"
+
+#include <algorithm>
+#include <cmath>
+#include "parallel.h"
+#include "simulation.h"
+
+// Fixed-point units per pixel, for positions and velocities
+static const float FIXED_ONE = 256.0f;
+
+// Bits of the cell key sorted per radix pass
+static const int RADIX_BITS = 16;
+
+// Minimum distance used in place of zero so coincident centres do not produce NaNs
+static const float MIN_DIST_SQ = 1e-6f;
+
+static inline int16_t saturate16(float v) {
+    return static_cast<int16_t>(std::clamp(std::lrint(v), -32767L, 32767L));
+}
+
+static inline void setFixed(CompactParticle& p, int64_t x, int64_t y) {
+    p.tileX = static_cast<uint16_t>(x >> 16);
+    p.x = static_cast<uint16_t>(x);
+    p.tileY = static_cast<uint16_t>(y >> 16);
+    p.y = static_cast<uint16_t>(y);
+}
+
+bool CompactWorld::configure(float width, float height) {
+    const float limit = 65536.0f * COMPACT_TILE;
+    if (!(width >= 1.0f && height >= 1.0f && width < limit && height < limit)) return false;
+    width_ = static_cast<uint32_t>(width * FIXED_ONE);
+    height_ = static_cast<uint32_t>(height * FIXED_ONE);
+    particles_.clear();
+    radius_.assign(speciesCount(), 0.0f);
+    steps_ = 0;
+    collisions_ = 0;
+    return true;
+}
+
+void CompactWorld::populate(size_t count, const std::vector<std::pair<std::string, float>>& l, std::mt19937& rng) {
+    if (l.empty() || width_ == 0) return;
+    std::vector<uint16_t> species(l.size());
+    for (size_t s = 0; s < l.size(); ++s) {
+        species[s] = speciesId(l[s].first);
+        if (species[s] < radius_.size()) radius_[species[s]] = l[s].second;
+    }
+
+    std::uniform_int_distribution<size_t> type(0, l.size() - 1);
+    std::uniform_int_distribution<uint32_t> distX(0, width_ - 1);
+    std::uniform_int_distribution<uint32_t> distY(0, height_ - 1);
+    std::uniform_int_distribution<int> distV(-6, 6);
+    particles_.reserve(particles_.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        CompactParticle p;
+        p.species = species[type(rng)];
+        setFixed(p, distX(rng), distY(rng));
+        p.vx = static_cast<int16_t>(distV(rng) * static_cast<int>(FIXED_ONE));
+        p.vy = static_cast<int16_t>(distV(rng) * static_cast<int>(FIXED_ONE));
+        particles_.push_back(p);
+    }
+
+    // Cells as wide as the largest diameter keep overlapping pairs in neighbouring cells
+    float largest = 0.5f;
+    for (float r : radius_) largest = std::max(largest, r);
+    cellSize_ = 2.0f * largest;
+    perCell_ = static_cast<uint32_t>(std::ceil(cellSize_ * FIXED_ONE));
+    cols_ = std::max(1, static_cast<int>(std::ceil(width_ / FIXED_ONE / cellSize_)));
+    rows_ = std::max(1, static_cast<int>(std::ceil(height_ / FIXED_ONE / cellSize_)));
+}
+
+void CompactWorld::integrate(size_t begin, size_t end, float scale) {
+    for (size_t i = begin; i < end; ++i) {
+        CompactParticle& p = particles_[i];
+        int64_t r = std::lrint(radius_[p.species] * FIXED_ONE);
+        int64_t x = static_cast<int64_t>(p.fixedX()) + std::lrint(p.vx * scale);
+        int64_t y = static_cast<int64_t>(p.fixedY()) + std::lrint(p.vy * scale);
+        int32_t vx = p.vx, vy = p.vy;
+
+        // Bounce off the world edges
+        if (x - r < 0) { x = r; vx = -vx; }
+        if (x + r > width_) { x = width_ - r; vx = -vx; }
+        if (y - r < 0) { y = r; vy = -vy; }
+        if (y + r > height_) { y = height_ - r; vy = -vy; }
+
+        setFixed(p, std::clamp<int64_t>(x, 0, width_ - 1), std::clamp<int64_t>(y, 0, height_ - 1));
+        p.vx = static_cast<int16_t>(std::clamp(vx, -32767, 32767));
+        p.vy = static_cast<int16_t>(std::clamp(vy, -32767, 32767));
+    }
+}
+
+// Cell of a particle as row * cols + column, in 64 bits: a wide world has
+// more cells than a uint32 counts
+uint64_t CompactWorld::cellKey(const CompactParticle& p) const {
+    // Integer division: a float quotient of a 32-bit position can land in the wrong cell
+    uint32_t cx = std::min<uint32_t>(p.fixedX() / perCell_, cols_ - 1);
+    uint32_t cy = std::min<uint32_t>(p.fixedY() / perCell_, rows_ - 1);
+    return static_cast<uint64_t>(cy) * cols_ + cx;
+}
+
+// Stable LSD radix sort of particle indices by cell key, then one entry per
+// occupied cell. Nothing is sized by the world's area, so a sparse wide
+// world costs the same as a small dense one.
+void CompactWorld::bin() {
+    size_t n = particles_.size();
+    order_.resize(n);
+    cellOf_.resize(n);
+
+    uint64_t cells = static_cast<uint64_t>(cols_) * rows_;
+    int bits = 1;
+    while (bits < 64 && (uint64_t(1) << bits) < cells) bits++;
+    int passes = (bits + RADIX_BITS - 1) / RADIX_BITS;
+    int digitBits = (bits + passes - 1) / passes;
+    uint64_t mask = (uint64_t(1) << digitBits) - 1;
+
+    // cellOf_ is the other buffer until the sort is done; the last pass lands in order_
+    for (int pass = 0; pass < passes; ++pass) {
+        bool last = (passes - 1 - pass) % 2 == 0;
+        std::vector<uint32_t>& out = last ? order_ : cellOf_;
+        const std::vector<uint32_t>& in = last ? cellOf_ : order_;
+        int shift = pass * digitBits;
+        auto index = [&](size_t k) { return pass == 0 ? static_cast<uint32_t>(k) : in[k]; };
+        radix_.assign(mask + 2, 0);
+        for (size_t k = 0; k < n; ++k) radix_[((cellKey(particles_[index(k)]) >> shift) & mask) + 1]++;
+        for (size_t d = 0; d <= mask; ++d) radix_[d + 1] += radix_[d];
+        for (size_t k = 0; k < n; ++k) {
+            uint32_t i = index(k);
+            out[radix_[(cellKey(particles_[i]) >> shift) & mask]++] = i;
+        }
+    }
+
+    cellKeys_.clear();
+    cellStart_.clear();
+    for (size_t k = 0; k < n; ++k) {
+        uint64_t key = cellKey(particles_[order_[k]]);
+        if (cellKeys_.empty() || cellKeys_.back() != key) {
+            cellKeys_.push_back(key);
+            cellStart_.push_back(static_cast<uint32_t>(k));
+        }
+        cellOf_[order_[k]] = static_cast<uint32_t>(cellKeys_.size() - 1);
+    }
+    cellStart_.push_back(static_cast<uint32_t>(n));
+
+    // First occupied cell at or after the left neighbour in the rows above and
+    // below. Both targets grow with the key, so one sweep each finds them all.
+    size_t occupied = cellKeys_.size();
+    above_.resize(occupied);
+    below_.resize(occupied);
+    size_t up = 0, down = 0;
+    for (size_t c = 0; c < occupied; ++c) {
+        uint64_t cx = cellKeys_[c] % cols_;
+        uint64_t cy = cellKeys_[c] / cols_;
+        uint64_t left = cx > 0 ? cx - 1 : 0;
+        uint64_t target = cy > 0 ? (cy - 1) * cols_ + left : 0;
+        while (up < occupied && cellKeys_[up] < target) up++;
+        target = (cy + 1) * cols_ + left;
+        while (down < occupied && cellKeys_[down] < target) down++;
+        above_[c] = static_cast<uint32_t>(up);
+        below_[c] = static_cast<uint32_t>(down);
+    }
+}
+
+// Same impulse and separation as the World's narrow phase, on the stored velocities
+void CompactWorld::collide(const Contact& contact) {
+    CompactParticle& a = particles_[contact.a];
+    CompactParticle& b = particles_[contact.b];
+    float cx = static_cast<int32_t>(a.fixedX() - b.fixedX()) / FIXED_ONE;
+    float cy = static_cast<int32_t>(a.fixedY() - b.fixedY()) / FIXED_ONE;
+    float ra = radius_[a.species], rb = radius_[b.species];
+    float total = ra + rb;
+    // An earlier contact of this step may have pushed the pair apart
+    if (cx * cx + cy * cy >= total * total) return;
+
+    float distSq = std::max(cx * cx + cy * cy, MIN_DIST_SQ);
+    float rc = ((a.vx - b.vx) * cx + (a.vy - b.vy) * cy) / FIXED_ONE;
+    float s = rc / distSq;
+    float ka = ((2.0f * rb) / total) * s * FIXED_ONE;
+    float kb = ((2.0f * ra) / total) * s * FIXED_ONE;
+    a.vx = saturate16(a.vx - ka * cx);
+    a.vy = saturate16(a.vy - ka * cy);
+    b.vx = saturate16(b.vx + kb * cx);
+    b.vy = saturate16(b.vy + kb * cy);
+
+    float dist = std::sqrt(distSq);
+    float overlap = 0.5f * (total - dist + 1.0f);
+    int64_t sx = std::lrint(cx / dist * overlap * FIXED_ONE);
+    int64_t sy = std::lrint(cy / dist * overlap * FIXED_ONE);
+    auto move = [&](CompactParticle& p, int64_t dx, int64_t dy) {
+        setFixed(p, std::clamp<int64_t>(p.fixedX() + dx, 0, width_ - 1),
+                 std::clamp<int64_t>(p.fixedY() + dy, 0, height_ - 1));
+    };
+    move(a, sx, sy);
+    move(b, -sx, -sy);
+}
+
+void CompactWorld::step() {
+    steps_++;
+    size_t n = particles_.size();
+    float scale = temperature * (1.0f - friction);
+    parallelFor(pool, n, [&](size_t begin, size_t end, size_t) { integrate(begin, end, scale); });
+
+    bin();
+    size_t chunks = chunkCount(n);
+    if (contacts_.size() < chunks) contacts_.resize(chunks);
+    parallelFor(pool, n, [&](size_t begin, size_t end, size_t c) {
+        std::vector<Contact>& local = contacts_[c];
+        local.clear();
+        for (size_t i = begin; i < end; ++i) {
+            const CompactParticle& a = particles_[i];
+            size_t own = cellOf_[i];
+            int cx = static_cast<int>(cellKeys_[own] % cols_);
+            int cy = static_cast<int>(cellKeys_[own] / cols_);
+            float ra = radius_[a.species];
+            for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, rows_ - 1); ++y) {
+                // The neighbouring cells of one row are adjacent in key order
+                uint64_t last = static_cast<uint64_t>(y) * cols_ + std::min(cx + 1, cols_ - 1);
+                size_t cell = own;
+                if (y < cy) cell = above_[own];
+                else if (y > cy) cell = below_[own];
+                else if (own > 0 && cx > 0 && cellKeys_[own - 1] + 1 == cellKeys_[own]) cell = own - 1;
+                for (; cell < cellKeys_.size() && cellKeys_[cell] <= last; ++cell) {
+                    for (uint32_t k = cellStart_[cell]; k < cellStart_[cell + 1]; ++k) {
+                        uint32_t j = order_[k];
+                        if (j <= i) continue;
+                        const CompactParticle& b = particles_[j];
+                        float dx = static_cast<int32_t>(b.fixedX() - a.fixedX()) / FIXED_ONE;
+                        float dy = static_cast<int32_t>(b.fixedY() - a.fixedY()) / FIXED_ONE;
+                        float minDist = ra + radius_[b.species];
+                        if (dx * dx + dy * dy < minDist * minDist) local.push_back({static_cast<uint32_t>(i), j});
+                    }
+                }
+            }
+        }
+    });
+
+    // Responses change positions and velocities, so they are applied serially in contact order
+    collisions_ = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        for (const Contact& contact : contacts_[c]) collide(contact);
+        collisions_ += contacts_[c].size();
+    }
+}
+
+double CompactWorld::bytesPerParticle() const {
+    if (particles_.empty()) return 0.0;
+    size_t bytes = particles_.capacity() * sizeof(CompactParticle);
+    bytes += (cellOf_.capacity() + order_.capacity() + radix_.capacity() + cellStart_.capacity() + above_.capacity() +
+              below_.capacity()) * sizeof(uint32_t);
+    bytes += cellKeys_.capacity() * sizeof(uint64_t);
+    bytes += radius_.capacity() * sizeof(float) + contacts_.capacity() * sizeof(std::vector<Contact>);
+    for (const auto& chunk : contacts_) bytes += chunk.capacity() * sizeof(Contact);
+    return static_cast<double>(bytes) / particles_.size();
+}
+
+uint64_t CompactWorld::hash() const {
+    // FNV-1a per chunk, chunk hashes folded in order
+    size_t chunks = chunkCount(particles_.size());
+    std::vector<uint64_t> partial(chunks);
+    parallelFor(pool, particles_.size(), [&](size_t begin, size_t end, size_t c) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (size_t i = begin; i < end; ++i) {
+            const CompactParticle& p = particles_[i];
+            for (uint64_t v : {static_cast<uint64_t>(p.fixedX()) << 32 | p.fixedY(),
+                               static_cast<uint64_t>(static_cast<uint16_t>(p.vx)) << 32 |
+                                   static_cast<uint64_t>(static_cast<uint16_t>(p.vy)) << 16 | p.species}) {
+                h = (h ^ v) * 0x100000001b3ULL;
+            }
+        }
+        partial[c] = h;
+    });
+    uint64_t h = steps_ ^ particles_.size() * 0x9e3779b97f4a7c15ULL;
+    for (uint64_t v : partial) h = (h ^ v) * 0x100000001b3ULL;
+    return h;
+}
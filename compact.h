@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "collision.h"
+
+class ThreadPool;
+
+// Side of a world tile in pixels; positions are fixed point inside their tile
+const int COMPACT_TILE = 256;
+
+// 14 bytes per particle. The absolute position is tile << 16 | offset in
+// 1/256 px, so every pixel of a 16.7M px wide world is represented exactly;
+// the velocity is stored once, at temperature 1, in 1/256 px per step. The
+// radius follows from the species.
+struct CompactParticle {
+    uint16_t tileX, tileY;
+    uint16_t x, y;         // Offset inside the tile, 1/256 px
+    int16_t vx, vy;
+    uint16_t species;
+
+    uint32_t fixedX() const { return static_cast<uint32_t>(tileX) << 16 | x; }
+    uint32_t fixedY() const { return static_cast<uint32_t>(tileY) << 16 | y; }
+};
+static_assert(sizeof(CompactParticle) == 14, "CompactParticle is packed by construction");
+
+// Particle store for runs far beyond what World holds, e.g. 100M particles
+// on one node. It simulates motion at the world temperature and friction,
+// wall bounces and elastic collisions between the species' discs; there are
+// no trails, reactions or decays, and positions move in whole 1/256 px.
+//
+// Each step integrates on the pool, bins particles into a uniform grid of
+// cells as wide as the largest diameter, finds contacts per fixed chunk on the
+// pool and applies them in contact order, so runs are repeatable on any
+// thread count. Binning radix-sorts uint32 indices by 64-bit cell key and
+// keeps only the occupied cells, 8 to 28 bytes per particle however
+// wide the world is.
+class CompactWorld {
+public:
+    float temperature = 0.5f;
+    float friction = 0.0f;
+    ThreadPool* pool = nullptr;
+
+    // World of width x height pixels, at most 65536 tiles on a side; drops all particles
+    bool configure(float width, float height);
+    // Appends count particles of random species from l at random positions with velocities in [-6, 6]
+    void populate(size_t count, const std::vector<std::pair<std::string, float>>& l, std::mt19937& rng);
+    void step();
+
+    size_t size() const { return particles_.size(); }
+    const CompactParticle& operator[](size_t i) const { return particles_[i]; }
+    float x(size_t i) const { return particles_[i].fixedX() / 256.0f; }
+    float y(size_t i) const { return particles_[i].fixedY() / 256.0f; }
+    float radius(size_t i) const { return radius_[particles_[i].species]; }
+
+    uint64_t steps() const { return steps_; }
+    uint64_t collisions() const { return collisions_; }  // Contacts of the last step
+
+    // Heap bytes held (particles, grid and contact scratch) divided by the particle count
+    double bytesPerParticle() const;
+    // Hash of every particle's fields in order
+    uint64_t hash() const;
+
+private:
+    void integrate(size_t begin, size_t end, float scale);
+    uint64_t cellKey(const CompactParticle& p) const;
+    void bin();
+    void collide(const Contact& c);
+
+    uint32_t width_ = 0, height_ = 0;  // 1/256 px
+    float cellSize_ = 1.0f;            // px
+    uint32_t perCell_ = 256;           // Cell size in 1/256 px
+    int cols_ = 0, rows_ = 0;
+    uint64_t steps_ = 0;
+    uint64_t collisions_ = 0;
+    std::vector<CompactParticle> particles_;
+    std::vector<float> radius_;        // Per species id
+    std::vector<uint32_t> cellOf_;     // Per particle, index into cellKeys_
+    std::vector<uint32_t> order_;      // Particle indices sorted by cell
+    std::vector<uint32_t> radix_;      // Digit counts
+    std::vector<uint64_t> cellKeys_;   // Occupied cells, ascending
+    std::vector<uint32_t> cellStart_;  // Per occupied cell, plus the end: offsets into order_
+    std::vector<uint32_t> above_, below_;  // Per occupied cell, where its neighbours in the next rows start
+    std::vector<std::vector<Contact>> contacts_;  // Per chunk
+};
@@ -0,0 +1,428 @@
+#include "event_driven.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "parallel.h"
+#include "simulation.h"
+
+// Contacts are predicted this far inside touching distance, so resolveCollision
+// sees the pair as overlapping
+static const double CONTACT_SLACK = 1e-3;
+
+void EventDrivenEngine::track(World& w, size_t i, double t) {
+    const Particle& p = w.particles[i];
+    x_[i] = p.x;
+    y_[i] = p.y;
+    vx_[i] = p.frozen ? 0.0 : p.init_vx * scale_;
+    vy_[i] = p.frozen ? 0.0 : p.init_vy * scale_;
+    time_[i] = t;
+}
+
+void EventDrivenEngine::drift(World& w, size_t i, double t) {
+    x_[i] += vx_[i] * (t - time_[i]);
+    y_[i] += vy_[i] * (t - time_[i]);
+    time_[i] = t;
+    Particle& p = w.particles[i];
+    p.x = static_cast<float>(x_[i]);
+    p.y = static_cast<float>(y_[i]);
+    p.vx = static_cast<float>(vx_[i]);
+    p.vy = static_cast<float>(vy_[i]);
+}
+
+void EventDrivenEngine::place(size_t i) {
+    uint32_t cell = static_cast<uint32_t>(grid_.cellY(static_cast<float>(y_[i])) * grid_.cols +
+                                          grid_.cellX(static_cast<float>(x_[i])));
+    moveTo(i, cell);
+}
+
+void EventDrivenEngine::moveTo(size_t i, uint32_t cell) {
+    if (cellOf_[i] == cell) return;
+    if (cellOf_[i] != NO_CELL) {
+        // Swap-remove from the old cell's list
+        std::vector<uint32_t>& from = cells_[cellOf_[i]];
+        uint32_t last = from.back();
+        from[slot_[i]] = last;
+        slot_[last] = slot_[i];
+        from.pop_back();
+    }
+    cellOf_[i] = cell;
+    slot_[i] = static_cast<uint32_t>(cells_[cell].size());
+    cells_[cell].push_back(static_cast<uint32_t>(i));
+}
+
+void EventDrivenEngine::bin() {
+    size_t cells = static_cast<size_t>(grid_.cols) * grid_.rows;
+    if (cells_.size() < cells) cells_.resize(cells);
+    for (auto& c : cells_) c.clear();
+    for (size_t i = 0; i < cellOf_.size(); ++i) {
+        if (dead_[i]) continue;
+        slot_[i] = static_cast<uint32_t>(cells_[cellOf_[i]].size());
+        cells_[cellOf_[i]].push_back(static_cast<uint32_t>(i));
+    }
+}
+
+void EventDrivenEngine::regrid(World& w, double t) {
+    for (size_t i = 0; i < w.particles.size(); ++i) {
+        if (!dead_[i]) drift(w, i, t);
+    }
+    grid_.build(w.particles);
+    cellOf_ = grid_.cellOf;
+    bin();
+    queue_ = {};
+    for (size_t i = 0; i < w.particles.size(); ++i) {
+        if (!dead_[i]) predict(w, i, t);
+    }
+}
+
+void EventDrivenEngine::rebuild(World& w) {
+    scale_ = static_cast<double>(w.temperature) * (1.0 - w.friction);
+    step_ = w.step;
+    edits_ = w.edits;
+    valid_ = true;
+
+    size_t n = w.particles.size();
+    for (auto* v : {&x_, &y_, &vx_, &vy_, &time_}) v->assign(n, 0.0);
+    count_.assign(n, 0);
+    overlapAfter_.assign(n, 0.0);
+    dead_.assign(n, 0);
+    slot_.assign(n, 0);
+
+    // Nothing sleeps here; the time-stepped pass lets them settle again afterwards
+    for (Particle& p : w.particles) {
+        if (p.asleep) wakeParticle(p);
+    }
+
+    double now = static_cast<double>(w.step);
+    for (size_t i = 0; i < n; ++i) track(w, i, now);
+    regrid(w, now);
+}
+
+void EventDrivenEngine::predict(World& w, size_t i, double t) {
+    const Particle& p = w.particles[i];
+    double best = std::numeric_limits<double>::infinity();
+    Kind kind = WALL_X;
+    uint32_t other = 0;
+    // i itself may still be at an earlier time; cell crossings do not move it
+    double xi = x_[i] + vx_[i] * (t - time_[i]);
+    double yi = y_[i] + vy_[i] * (t - time_[i]);
+
+    // Walls; a particle already past one (pushed out by a contact, or spawned
+    // there) is clamped back at once
+    auto wall = [&](double pos, double v, float limit, Kind k) {
+        double hit = std::numeric_limits<double>::infinity();
+        // Tested in float, as the bounce clamps in float
+        float at = static_cast<float>(pos);
+        if (at < p.size || at > limit - p.size) hit = 0.0;
+        else if (v < 0.0) hit = (p.size - pos) / v;
+        else if (v > 0.0) hit = (limit - p.size - pos) / v;
+        hit = std::max(hit, 0.0);
+        if (hit < best) {
+            best = hit;
+            kind = k;
+        }
+    };
+    wall(xi, vx_[i], WINDOW_WIDTH, WALL_X);
+    wall(yi, vy_[i], WINDOW_HEIGHT, WALL_Y);
+
+    // Another particle, at its position at time t
+    auto pair = [&](uint32_t j) {
+        if (j == i || dead_[j]) return;
+        const Particle& q = w.particles[j];
+
+        double dx = x_[j] + vx_[j] * (t - time_[j]) - xi;
+        double dy = y_[j] + vy_[j] * (t - time_[j]) - yi;
+        double dvx = vx_[j] - vx_[i];
+        double dvy = vy_[j] - vy_[i];
+        double b = dx * dvx + dy * dvy;
+        if (b >= 0.0) return;  // Not approaching
+
+        double radius = static_cast<double>(p.size) + q.size;
+        double distSq = dx * dx + dy * dy;
+        double hit = std::max(std::max(overlapAfter_[i], overlapAfter_[j]) - t, 0.0);
+        if (distSq >= radius * radius) {
+            double contact = radius - CONTACT_SLACK;
+            double vv = dvx * dvx + dvy * dvy;
+            double disc = b * b - vv * (distSq - contact * contact);
+            if (disc < 0.0) return;
+            hit = (-b - std::sqrt(disc)) / vv;
+        }
+        // Ties go to the lower index, as if every particle were scanned in order
+        if (hit < best || (hit == best && kind == PAIR && j < other)) {
+            best = hit;
+            kind = PAIR;
+            other = j;
+        }
+    };
+
+    // Only the 3x3 cells around i: cells are a largest diameter wide, so a
+    // particle further away can only reach i after one of the two crosses
+    // into the other's neighbourhood and predicts again
+    int cx = static_cast<int>(cellOf_[i] % grid_.cols);
+    int cy = static_cast<int>(cellOf_[i] / grid_.cols);
+    for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, grid_.rows - 1); ++y) {
+        for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, grid_.cols - 1); ++x) {
+            for (uint32_t j : cells_[static_cast<size_t>(y) * grid_.cols + x]) pair(j);
+        }
+    }
+
+    // Leaving the cell, after the contacts so a contact wins a tie; inner cell
+    // edges only, the outer cells reach past the walls
+    auto edge = [&](double pos, double v, int c, int cols, Kind k) {
+        double hit = std::numeric_limits<double>::infinity();
+        if (v > 0.0 && c + 1 < cols) hit = ((c + 1) * static_cast<double>(grid_.cellSize) - pos) / v;
+        else if (v < 0.0 && c > 0) hit = (c * static_cast<double>(grid_.cellSize) - pos) / v;
+        hit = std::max(hit, 0.0);
+        if (hit < best) {
+            best = hit;
+            kind = k;
+        }
+    };
+    edge(xi, vx_[i], cx, grid_.cols, CELL_X);
+    edge(yi, vy_[i], cy, grid_.rows, CELL_Y);
+
+    if (best == std::numeric_limits<double>::infinity()) return;
+    queue_.push({t + best, static_cast<uint32_t>(i), other, count_[i], kind == PAIR ? count_[other] : 0, kind});
+}
+
+void EventDrivenEngine::appendSpawned(World& w, double t) {
+    if (w.spawned.empty()) return;
+    size_t first = w.particles.size();
+    for (auto& p : w.spawned) w.particles.push_back(std::move(p));
+    w.spawned.clear();
+
+    size_t n = w.particles.size();
+    for (auto* v : {&x_, &y_, &vx_, &vy_, &time_}) v->resize(n, 0.0);
+    count_.resize(n, 0);
+    overlapAfter_.resize(n, t);
+    dead_.resize(n, 0);
+    cellOf_.resize(n, NO_CELL);
+    slot_.resize(n, 0);
+    bool outgrown = false;
+    for (size_t i = first; i < n; ++i) {
+        track(w, i, t);
+        outgrown = outgrown || 2.0f * w.particles[i].size > grid_.cellSize;
+    }
+    // A product larger than the cells were sized for could miss contacts two cells away
+    if (outgrown) {
+        regrid(w, t);
+        return;
+    }
+    for (size_t i = first; i < n; ++i) place(i);
+    for (size_t i = first; i < n; ++i) predict(w, i, t);
+}
+
+void EventDrivenEngine::removeDead(World& w, double t) {
+    const uint32_t REMOVED = UINT32_MAX;
+    size_t n = w.particles.size();
+    ArenaVector<uint32_t> index(n, REMOVED, ArenaAllocator<uint32_t>(w.arena));
+    size_t out = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (dead_[i]) continue;
+        index[i] = static_cast<uint32_t>(out);
+        if (out != i) {
+            w.particles[out] = std::move(w.particles[i]);
+            x_[out] = x_[i];
+            y_[out] = y_[i];
+            vx_[out] = vx_[i];
+            vy_[out] = vy_[i];
+            time_[out] = time_[i];
+            count_[out] = count_[i];
+            overlapAfter_[out] = overlapAfter_[i];
+            cellOf_[out] = cellOf_[i];
+        }
+        out++;
+    }
+    w.particles.resize(out);
+    for (auto* v : {&x_, &y_, &vx_, &vy_, &time_, &overlapAfter_}) v->resize(out);
+    count_.resize(out);
+    cellOf_.resize(out);
+    slot_.resize(out);
+    dead_.assign(out, 0);
+    // Cells are kept as the crossings left them; recomputing them from the
+    // positions could disagree at a cell edge with the queued crossings
+    bin();
+
+    // Renumber the queue; a particle whose live prediction named a removed partner predicts again
+    std::vector<Event> kept;
+    ArenaVector<uint32_t> orphans{ArenaAllocator<uint32_t>(w.arena)};
+    kept.reserve(queue_.size());
+    while (!queue_.empty()) {
+        Event e = queue_.top();
+        queue_.pop();
+        if (index[e.owner] == REMOVED) continue;
+        e.owner = index[e.owner];
+        if (e.kind == PAIR) {
+            if (index[e.other] == REMOVED) {
+                if (e.ownerCount == count_[e.owner]) orphans.push_back(e.owner);
+                continue;
+            }
+            e.other = index[e.other];
+        }
+        kept.push_back(e);
+    }
+    queue_ = decltype(queue_)(std::greater<Event>(), std::move(kept));
+    for (uint32_t i : orphans) predict(w, i, t);
+}
+
+void EventDrivenEngine::advance(World& w, uint64_t steps) {
+    uint64_t allocationsBefore = heapAllocationCount.load(std::memory_order_relaxed);
+    double scale = static_cast<double>(w.temperature) * (1.0 - w.friction);
+    if (!valid_ || w.step != step_ || w.edits != edits_ || w.particles.size() != x_.size() || scale != scale_) {
+        rebuild(w);
+    }
+
+    uint64_t mergesBefore = w.merges;
+    uint64_t decaysBefore = w.decays;
+    uint64_t collisions = 0;
+    w.step += steps;
+    double end = static_cast<double>(w.step);
+
+    while (!queue_.empty() && queue_.top().time <= end) {
+        Event e = queue_.top();
+        queue_.pop();
+
+        bool ownerValid = count_[e.owner] == e.ownerCount;
+        bool otherValid = e.kind != PAIR || count_[e.other] == e.otherCount;
+        if (!ownerValid || !otherValid) {
+            // The partner changed course; the owner still needs a prediction
+            stale_++;
+            if (ownerValid) {
+                drift(w, e.owner, e.time);
+                predict(w, e.owner, e.time);
+            }
+            continue;
+        }
+        if (e.kind == CELL_X || e.kind == CELL_Y) {
+            // Only the neighbourhood changes; the trajectory and every prediction naming i stay valid
+            size_t i = e.owner;
+            int64_t step = (e.kind == CELL_X ? vx_[i] : vy_[i]) > 0.0 ? 1 : -1;
+            if (e.kind == CELL_Y) step *= grid_.cols;
+            moveTo(i, static_cast<uint32_t>(cellOf_[i] + step));
+            crossings_++;
+            predict(w, i, e.time);
+            continue;
+        }
+        events_++;
+
+        if (e.kind != PAIR) {
+            size_t i = e.owner;
+            drift(w, i, e.time);
+            Particle& p = w.particles[i];
+            // Same bounce as the time-stepped pass, but only when moving outwards
+            if (e.kind == WALL_X) {
+                bool low = p.x * 2.0f < WINDOW_WIDTH;
+                p.x = std::clamp(p.x, p.size, WINDOW_WIDTH - p.size);
+                if (low ? p.init_vx < 0.0f : p.init_vx > 0.0f) p.init_vx *= -1.0f;
+            } else {
+                bool low = p.y * 2.0f < WINDOW_HEIGHT;
+                p.y = std::clamp(p.y, p.size, WINDOW_HEIGHT - p.size);
+                if (low ? p.init_vy < 0.0f : p.init_vy > 0.0f) p.init_vy *= -1.0f;
+            }
+            track(w, i, e.time);
+            place(i);
+            count_[i]++;
+            predict(w, i, e.time);
+            continue;
+        }
+
+        size_t i = e.owner, j = e.other;
+        drift(w, i, e.time);
+        drift(w, j, e.time);
+        Particle& a = w.particles[i];
+        Particle& b = w.particles[j];
+
+        // Frozen particles are fixed obstacles: undo whatever the response did to them.
+        // Only the fields it touches are kept; copying a Particle would allocate its trail
+        struct Pose {
+            float x, y, vx, vy;
+        };
+        Pose frozenA{a.x, a.y, a.init_vx, a.init_vy};
+        Pose frozenB{b.x, b.y, b.init_vx, b.init_vy};
+        // Marking a particle merged makes resolveCollision bounce instead of react
+        bool holdA = a.frozen && !a.merged;
+        bool holdB = b.frozen && !b.merged;
+        if (holdA) a.merged = true;
+        if (holdB) b.merged = true;
+        uint64_t merges = w.merges;
+        resolveCollision(w, a, b);
+        collisions++;
+        if (holdA) a.merged = false;
+        if (holdB) b.merged = false;
+        if (w.merges != merges) {
+            // The inputs are consumed; bumping their counters drops their queued events
+            dead_[i] = 1;
+            dead_[j] = 1;
+            count_[i]++;
+            count_[j]++;
+            appendSpawned(w, e.time);
+            continue;
+        }
+        overlapAfter_[i] = e.time + 1.0;
+        overlapAfter_[j] = e.time + 1.0;
+        if (a.frozen) {
+            a.x = frozenA.x;
+            a.y = frozenA.y;
+            a.init_vx = frozenA.vx;
+            a.init_vy = frozenA.vy;
+        }
+        if (b.frozen) {
+            b.x = frozenB.x;
+            b.y = frozenB.y;
+            b.init_vx = frozenB.vx;
+            b.init_vy = frozenB.vy;
+        }
+
+        track(w, i, e.time);
+        track(w, j, e.time);
+        place(i);
+        place(j);
+        count_[i]++;
+        count_[j]++;
+        predict(w, i, e.time);
+        predict(w, j, e.time);
+        appendSpawned(w, e.time);
+    }
+
+    // Bring everyone to the end of the advance and update trails
+    parallelFor(w.pool, w.particles.size(), [&](size_t begin, size_t stop, size_t) {
+        for (size_t i = begin; i < stop; ++i) {
+            if (dead_[i]) continue;
+            drift(w, i, end);
+            if (!w.particles[i].frozen) updateTrail(w, w.particles[i]);
+        }
+    });
+
+    // Decays, serially in particle order because products use the world RNG
+    ArenaVector<size_t> decayed{ArenaAllocator<size_t>(w.arena)};
+    for (size_t i = 0; i < w.particles.size(); ++i) {
+        Particle& p = w.particles[i];
+        if (p.frozen || dead_[i]) continue;
+        bool changed = false;
+        for (uint64_t k = 0; k < steps && p.size >= DECAY_SIZE; ++k) {
+            if (decayParticle(p)) {
+                emitDecay(w, p);
+                changed = true;
+            }
+        }
+        if (changed) decayed.push_back(i);
+    }
+    appendSpawned(w, end);
+    for (size_t i : decayed) {
+        count_[i]++;
+        predict(w, i, end);
+    }
+    if (std::find(dead_.begin(), dead_.end(), 1) != dead_.end()) removeDead(w, end);
+
+    step_ = w.step;
+    edits_ = w.edits;
+    w.gridFresh = false;
+
+    measureObservables(w);
+    w.observables.collisions = collisions;
+    w.observables.merges = w.merges - mergesBefore;
+    w.observables.decays = w.decays - decaysBefore;
+
+    w.arena.reset();
+    w.observables.allocations = heapAllocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+}
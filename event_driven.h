@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+#include "collision.h"
+
+struct World;
+
+// Event-driven alternative to updateParticles for sparse gases. Between
+// events every particle moves in a straight line at init_v * temperature *
+// (1 - friction) per step, so the engine predicts exact contact and wall-hit
+// times, keeps them in a priority queue and jumps from event to event.
+// Contacts are handled by resolveCollision (elastic response or a reaction
+// via reactionOutput), walls flip the velocity as in the time-stepped pass.
+//
+// Each particle keeps only its earliest predicted event. When a particle's
+// trajectory changes its event counter is bumped, which invalidates every
+// queued prediction involving it; a stale event whose predicting particle is
+// unchanged makes that particle re-predict.
+//
+// Reactions consume their inputs, as in the time-stepped pass: both are
+// marked dead at the event, ignored by later predictions and removed from the
+// world at the end of the advance. Frozen particles never react.
+//
+// Pairs that already overlap (spawned on top of each other, or squeezed
+// against a wall) are resolved at once, but each particle gets at most one
+// such event per step, like the per-step push of the time-stepped pass;
+// otherwise a squeezed particle would bounce forever without time advancing.
+//
+// The temperature field is not sampled: straight-line motion needs one speed
+// per particle, so the engine uses the global temperature throughout. Sleep
+// is not either: taking over wakes every sleeper, and nothing settles while
+// the engine runs.
+//
+// Predictions only look at the 3x3 cells of a UniformGrid around the
+// particle, and leaving a cell is an event of its own, after which the
+// particle predicts against its new neighbourhood. Cells are sized for the
+// largest particle; a reaction product that outgrows them rebuilds the grid
+// and every prediction. The engine pays off when events are rare compared to
+// particle-steps: low density, slow particles, long advances. Trails, decays
+// and observables are updated once per advance call, not per step inside it.
+class EventDrivenEngine {
+public:
+    // Moves the world forward by steps time units
+    void advance(World& w, uint64_t steps);
+
+    // Forces the predictions to be rebuilt on the next advance
+    void invalidate() { valid_ = false; }
+
+    uint64_t events() const { return events_; }       // Collision and wall events processed
+    uint64_t crossings() const { return crossings_; } // Cell crossings processed
+    uint64_t staleEvents() const { return stale_; }   // Invalidated predictions skipped
+
+private:
+    enum Kind : uint8_t { PAIR, WALL_X, WALL_Y, CELL_X, CELL_Y };
+    static constexpr uint32_t NO_CELL = UINT32_MAX;
+
+    struct Event {
+        double time;
+        uint32_t owner, other;         // other is only set for PAIR
+        uint32_t ownerCount, otherCount;
+        Kind kind;
+
+        bool operator>(const Event& e) const { return time > e.time; }
+    };
+
+    void rebuild(World& w);
+    void track(World& w, size_t i, double t);
+    void drift(World& w, size_t i, double t);
+    void predict(World& w, size_t i, double t);
+    void place(size_t i);
+    void moveTo(size_t i, uint32_t cell);
+    void bin();
+    void regrid(World& w, double t);
+    void appendSpawned(World& w, double t);
+    void removeDead(World& w, double t);
+
+    bool valid_ = false;
+    double scale_ = 0.0;       // temperature * (1 - friction) the predictions assume
+    uint64_t step_ = 0;        // World step the engine state corresponds to
+    uint64_t edits_ = 0;
+
+    // Per particle, indexed like World::particles
+    std::vector<double> x_, y_, vx_, vy_, time_;
+    std::vector<uint32_t> count_;
+    std::vector<double> overlapAfter_;  // Time from which an existing overlap is resolved again
+    std::vector<uint8_t> dead_;         // Consumed by a reaction during this advance
+    std::vector<uint32_t> cellOf_;      // Cell the particle's trajectory is in, advanced by crossings
+    std::vector<uint32_t> slot_;        // Position in cells_[cellOf_]
+
+    UniformGrid grid_;                  // Cell geometry and the initial binning
+    // Particle indices per cell, in no particular order
+    std::vector<std::vector<uint32_t>> cells_;
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue_;
+    uint64_t events_ = 0;
+    uint64_t crossings_ = 0;
+    uint64_t stale_ = 0;
+};
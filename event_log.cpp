@@ -0,0 +1,170 @@
+#include "event_log.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+
+EventLog eventLog;
+
+static const char* eventTypeName(EventType t) {
+    switch (t) {
+        case EventType::Collision: return "collision";
+        case EventType::Merge: return "merge";
+        case EventType::Decay: return "decay";
+        case EventType::Spawn: return "spawn";
+    }
+    return "unknown";
+}
+
+const char* logLevelName(LogLevel l) {
+    switch (l) {
+        case LogLevel::Off: return "off";
+        case LogLevel::Reactions: return "reactions";
+        case LogLevel::Collisions: return "collisions";
+    }
+    return "off";
+}
+
+bool parseLogLevel(std::string s, LogLevel& out) {
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    if (s == "off") out = LogLevel::Off;
+    else if (s == "reactions") out = LogLevel::Reactions;
+    else if (s == "collisions") out = LogLevel::Collisions;
+    else return false;
+    return true;
+}
+
+EventLog::~EventLog() {
+    stop();
+}
+
+void EventLog::setLevel(LogLevel l) {
+    level_.store(static_cast<int>(l), std::memory_order_relaxed);
+    if (l != LogLevel::Off) start();
+}
+
+void EventLog::configure(const std::string& path, LogFormat format) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = path;
+    format_ = format;
+}
+
+void EventLog::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_.load()) return;
+
+    if (path_ == "-") {
+        out_ = stderr;
+    } else {
+        out_ = std::fopen(path_.c_str(), format_ == LogFormat::Binary ? "wb" : "w");
+        if (!out_) {
+            std::fprintf(stderr, "Failed to open event log %s\n", path_.c_str());
+            level_.store(static_cast<int>(LogLevel::Off));
+            return;
+        }
+    }
+    if (format_ == LogFormat::Binary) {
+        std::fwrite("PSEVLOG1", 1, 8, out_);
+    }
+
+    running_.store(true);
+    drainer_ = std::thread(&EventLog::drainLoop, this);
+}
+
+void EventLog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.load()) return;
+        running_.store(false);
+    }
+    drainer_.join();
+
+    // Pick up anything pushed after the drain thread's last pass
+    drainAll();
+    if (dropped() > 0) {
+        std::fprintf(stderr, "Event log dropped %llu events (ring full)\n",
+                     static_cast<unsigned long long>(dropped()));
+    }
+    if (out_ && out_ != stderr) std::fclose(out_);
+    else if (out_) std::fflush(out_);
+    out_ = nullptr;
+}
+
+uint64_t EventLog::dropped() const {
+    uint64_t total = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& r : rings_) total += r->dropped();
+    return total;
+}
+
+void EventLog::record(const Event& e) {
+    localRing().push(e);
+}
+
+EventRing& EventLog::localRing() {
+    // One ring per producer thread, registered on first use. The registry keeps
+    // it alive after the thread exits so the drain thread can still empty it.
+    thread_local std::shared_ptr<EventRing> ring;
+    if (!ring) {
+        ring = std::make_shared<EventRing>();
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings_.push_back(ring);
+    }
+    return *ring;
+}
+
+void EventLog::drainLoop() {
+    while (running_.load()) {
+        if (drainAll() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+}
+
+size_t EventLog::drainAll() {
+    std::vector<std::shared_ptr<EventRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings = rings_;
+    }
+    size_t n = 0;
+    for (auto& r : rings) {
+        n += r->drain([this](const Event& e) { write(e); });
+    }
+    if (n > 0) std::fflush(out_);
+    written_.fetch_add(n, std::memory_order_relaxed);
+    return n;
+}
+
+void EventLog::write(const Event& e) {
+    if (format_ == LogFormat::Binary) {
+        // Packed little-endian record: step u64, type u8, a/b/c u32, value f32
+        unsigned char buf[25];
+        uint8_t type = static_cast<uint8_t>(e.type);
+        std::memcpy(buf, &e.step, 8);
+        std::memcpy(buf + 8, &type, 1);
+        std::memcpy(buf + 9, &e.a, 4);
+        std::memcpy(buf + 13, &e.b, 4);
+        std::memcpy(buf + 17, &e.c, 4);
+        std::memcpy(buf + 21, &e.value, 4);
+        std::fwrite(buf, 1, sizeof(buf), out_);
+        return;
+    }
+
+    switch (e.type) {
+        case EventType::Collision:
+            std::fprintf(out_, "%llu %s %u %u\n", static_cast<unsigned long long>(e.step),
+                         eventTypeName(e.type), e.a, e.b);
+            break;
+        case EventType::Merge:
+            std::fprintf(out_, "%llu %s %u %u -> %u\n", static_cast<unsigned long long>(e.step),
+                         eventTypeName(e.type), e.a, e.b, e.c);
+            break;
+        case EventType::Decay:
+        case EventType::Spawn:
+            std::fprintf(out_, "%llu %s %u size=%.2f\n", static_cast<unsigned long long>(e.step),
+                         eventTypeName(e.type), e.a, e.value);
+            break;
+    }
+}
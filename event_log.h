@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Structured simulation event log.
+//
+// Producers (the simulation thread, which also applies decays once per step,
+// or each run's thread in a sweep) push fixed-size records into a per-thread
+// single-producer/single-consumer ring buffer, so the hot path never takes a
+// lock or touches a stream. A background thread drains every ring into a text
+// or binary sink. When the level is Off the only cost at a call site is one
+// relaxed atomic load.
+
+enum class LogLevel : int {
+    Off = 0,
+    Reactions = 1,  // merge, decay and spawn events
+    Collisions = 2  // everything above plus every overlapping pair
+};
+
+enum class EventType : uint8_t {
+    Collision = 0,
+    Merge = 1,
+    Decay = 2,
+    Spawn = 3
+};
+
+enum class LogFormat {
+    Text,
+    Binary
+};
+
+// One log record. Particle handles are Particle::id values; unused handles are 0.
+struct Event {
+    uint64_t step;
+    EventType type;
+    uint32_t a;      // collision/merge: first input, decay/spawn: the particle
+    uint32_t b;      // collision/merge: second input
+    uint32_t c;      // merge: product
+    float value;     // decay: new size, spawn: size
+};
+
+class EventRing {
+public:
+    static constexpr size_t CAPACITY = 1 << 14;  // must be a power of two
+
+    bool push(const Event& e) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= CAPACITY) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots_[tail & (CAPACITY - 1)] = e;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; only called from the drain thread.
+    template <typename F>
+    size_t drain(F&& sink) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        for (size_t i = head; i != tail; ++i) {
+            sink(slots_[i & (CAPACITY - 1)]);
+        }
+        head_.store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) std::atomic<uint64_t> dropped_{0};
+    Event slots_[CAPACITY];
+};
+
+class EventLog {
+public:
+    ~EventLog();
+
+    bool enabled(LogLevel l) const {
+        return level_.load(std::memory_order_relaxed) >= static_cast<int>(l);
+    }
+
+    LogLevel level() const { return static_cast<LogLevel>(level_.load(std::memory_order_relaxed)); }
+
+    // Changing the level away from Off starts the drain thread if it is not running yet.
+    void setLevel(LogLevel l);
+
+    // Sink used the next time the drain thread starts. Path "-" writes to stderr.
+    void configure(const std::string& path, LogFormat format);
+
+    void start();
+    void stop();
+
+    void collision(uint64_t step, uint32_t a, uint32_t b) {
+        if (enabled(LogLevel::Collisions)) record({step, EventType::Collision, a, b, 0, 0.0f});
+    }
+    void merge(uint64_t step, uint32_t a, uint32_t b, uint32_t product) {
+        if (enabled(LogLevel::Reactions)) record({step, EventType::Merge, a, b, product, 0.0f});
+    }
+    void decay(uint64_t step, uint32_t id, float newSize) {
+        if (enabled(LogLevel::Reactions)) record({step, EventType::Decay, id, 0, 0, newSize});
+    }
+    void spawn(uint64_t step, uint32_t id, float size) {
+        if (enabled(LogLevel::Reactions)) record({step, EventType::Spawn, id, 0, 0, size});
+    }
+
+    uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const;
+
+private:
+    void record(const Event& e);
+    EventRing& localRing();
+    void drainLoop();
+    size_t drainAll();
+    void write(const Event& e);
+
+    std::atomic<int> level_{static_cast<int>(LogLevel::Off)};
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> written_{0};
+
+    mutable std::mutex mutex_;  // guards rings_, the sink settings and start/stop
+    std::vector<std::shared_ptr<EventRing>> rings_;
+    std::string path_ = "events.log";
+    LogFormat format_ = LogFormat::Text;
+    FILE* out_ = nullptr;
+    std::thread drainer_;
+};
+
+extern EventLog eventLog;
+
+const char* logLevelName(LogLevel l);
+bool parseLogLevel(std::string s, LogLevel& out);
@@ -0,0 +1,41 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+
+std::atomic<uint64_t> heapAllocationCount{0};
+
+void* FrameArena::allocate(size_t bytes, size_t align) {
+    if (!blocks_.empty()) {
+        const Block& b = blocks_.back();
+        uintptr_t base = reinterpret_cast<uintptr_t>(b.data.get());
+        size_t start = ((base + offset_ + align - 1) & ~(uintptr_t(align) - 1)) - base;
+        if (start + bytes <= b.size) {
+            offset_ = start + bytes;
+            return b.data.get() + start;
+        }
+        usedBefore_ += offset_;
+    }
+
+    // Room for the alignment padding as well, new[] only guarantees the default alignment
+    size_t size = std::max(blockSize_, bytes + align);
+    blocks_.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+    offset_ = 0;
+    return allocate(bytes, align);
+}
+
+void FrameArena::reset() {
+    peak_ = std::max(peak_, used());
+    if (blocks_.size() > 1) {
+        size_t total = capacity();
+        blocks_.clear();
+        blocks_.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[total]), total});
+    }
+    offset_ = 0;
+    usedBefore_ = 0;
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const Block& b : blocks_) total += b.size;
+    return total;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Calls to the global operator new from every thread. The replacement that
+// counts them is in alloc_count.cpp, linked into particle_simulation and
+// particle_soak; anything else linking the core reads 0.
+extern std::atomic<uint64_t> heapAllocationCount;
+
+// Linear allocator for data that lives no longer than one step. Allocating
+// bumps an offset in the current block and nothing is freed on its own;
+// reset() drops everything at once. A step that needed several blocks leaves
+// one block of their combined size behind, so after a few steps the arena
+// stops calling the heap. Not thread-safe: allocate on the stepping thread,
+// before or after handing work to the pool.
+class FrameArena {
+public:
+    explicit FrameArena(size_t blockSize = 64 << 10) : blockSize_(blockSize) {}
+
+    void* allocate(size_t bytes, size_t align);
+    void reset();
+
+    size_t used() const { return usedBefore_ + offset_; }  // Bytes handed out since the last reset
+    size_t capacity() const;
+    size_t peak() const { return peak_; }  // Largest used() seen by reset()
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+    std::vector<Block> blocks_;
+    size_t offset_ = 0;      // Into blocks_.back()
+    size_t usedBefore_ = 0;  // Bytes taken from earlier blocks, padding included
+    size_t blockSize_;
+    size_t peak_ = 0;
+};
+
+// Standard allocator over a FrameArena; deallocate does nothing, so growing a
+// container leaves its old storage behind until the reset. Reserve when the
+// size is known.
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+    FrameArena* arena;
+
+    explicit ArenaAllocator(FrameArena& a) : arena(&a) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+// Must not outlive the step that created it
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,156 @@
+#include "frame_writer.h"
+
+#include <algorithm>
+#include <iostream>
+
+// Largest stored deflate block
+static const size_t DEFLATE_BLOCK = 65535;
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t n) {
+    static uint32_t table[256];
+    static bool ready = [] {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)ready;
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void putBigEndian(std::vector<uint8_t>& out, uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(v >> shift));
+}
+
+static bool writeChunk(FILE* out, const char type[4], const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> head;
+    putBigEndian(head, static_cast<uint32_t>(data.size()));
+    head.insert(head.end(), type, type + 4);
+    uint32_t crc = crc32(crc32(0, head.data() + 4, 4), data.data(), data.size());
+    std::vector<uint8_t> tail;
+    putBigEndian(tail, crc);
+    return std::fwrite(head.data(), 1, head.size(), out) == head.size() &&
+           std::fwrite(data.data(), 1, data.size(), out) == data.size() &&
+           std::fwrite(tail.data(), 1, tail.size(), out) == tail.size();
+}
+
+FrameWriter::~FrameWriter() {
+    close();
+}
+
+bool FrameWriter::openSequence(const std::string& pattern) {
+    close();
+    pattern_ = pattern;
+    size_t dot = pattern.rfind('.');
+    png_ = dot != std::string::npos && pattern.compare(dot, std::string::npos, ".png") == 0;
+    frames_ = 0;
+    return true;
+}
+
+bool FrameWriter::openPipe(const std::string& command) {
+    close();
+    pipe_ = popen(command.c_str(), "w");
+    if (!pipe_) {
+        std::cerr << "Failed to start " << command << "\n";
+        return false;
+    }
+    frames_ = 0;
+    return true;
+}
+
+void FrameWriter::close() {
+    if (pipe_) pclose(pipe_);
+    pipe_ = nullptr;
+    pattern_.clear();
+}
+
+// RGB truecolour, 8 bits, filter type 0 on every row
+bool FrameWriter::writePng(FILE* out, const uint8_t* rgba, int width, int height) {
+    static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> header;
+    putBigEndian(header, static_cast<uint32_t>(width));
+    putBigEndian(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+
+    size_t rowBytes = static_cast<size_t>(width) * 3 + 1;
+    scratch_.resize(rowBytes * height);
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = &scratch_[y * rowBytes];
+        const uint8_t* src = rgba + static_cast<size_t>(y) * width * 4;
+        row[0] = 0;
+        for (int x = 0; x < width; ++x) {
+            row[1 + 3 * x] = src[4 * x];
+            row[2 + 3 * x] = src[4 * x + 1];
+            row[3 + 3 * x] = src[4 * x + 2];
+        }
+    }
+
+    // zlib stream of stored blocks, then the Adler-32 of the raw bytes
+    std::vector<uint8_t> data = {0x78, 0x01};
+    data.reserve(scratch_.size() + scratch_.size() / DEFLATE_BLOCK * 5 + 16);
+    uint32_t s1 = 1, s2 = 0;
+    for (size_t pos = 0; pos < scratch_.size() || pos == 0; pos += DEFLATE_BLOCK) {
+        size_t n = std::min(DEFLATE_BLOCK, scratch_.size() - pos);
+        bool last = pos + n == scratch_.size();
+        data.push_back(last ? 1 : 0);
+        data.push_back(static_cast<uint8_t>(n));
+        data.push_back(static_cast<uint8_t>(n >> 8));
+        data.push_back(static_cast<uint8_t>(~n));
+        data.push_back(static_cast<uint8_t>(~n >> 8));
+        data.insert(data.end(), scratch_.begin() + pos, scratch_.begin() + pos + n);
+        for (size_t i = pos; i < pos + n; ++i) {
+            s1 = (s1 + scratch_[i]) % 65521;
+            s2 = (s2 + s1) % 65521;
+        }
+        if (last) break;
+    }
+    putBigEndian(data, s2 << 16 | s1);
+
+    return std::fwrite(SIGNATURE, 1, sizeof(SIGNATURE), out) == sizeof(SIGNATURE) &&
+           writeChunk(out, "IHDR", header) && writeChunk(out, "IDAT", data) && writeChunk(out, "IEND", {});
+}
+
+bool FrameWriter::writePpm(FILE* out, const uint8_t* rgba, int width, int height) {
+    std::fprintf(out, "P6\n%d %d\n255\n", width, height);
+    scratch_.resize(static_cast<size_t>(width) * height * 3);
+    for (size_t i = 0, n = static_cast<size_t>(width) * height; i < n; ++i) {
+        scratch_[3 * i] = rgba[4 * i];
+        scratch_[3 * i + 1] = rgba[4 * i + 1];
+        scratch_[3 * i + 2] = rgba[4 * i + 2];
+    }
+    return std::fwrite(scratch_.data(), 1, scratch_.size(), out) == scratch_.size();
+}
+
+bool FrameWriter::write(const uint8_t* rgba, int width, int height) {
+    if (pipe_) {
+        size_t bytes = static_cast<size_t>(width) * height * 4;
+        if (std::fwrite(rgba, 1, bytes, pipe_) != bytes) {
+            std::cerr << "Frame pipe closed\n";
+            close();
+            return false;
+        }
+        frames_++;
+        return true;
+    }
+    if (pattern_.empty()) return false;
+
+    std::vector<char> path(pattern_.size() + 32);
+    std::snprintf(path.data(), path.size(), pattern_.c_str(), static_cast<int>(frames_));
+    FILE* out = std::fopen(path.data(), "wb");
+    if (!out) {
+        std::cerr << "Failed to open " << path.data() << "\n";
+        return false;
+    }
+    bool ok = png_ ? writePng(out, rgba, width, height) : writePpm(out, rgba, width, height);
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write " << path.data() << "\n";
+        return false;
+    }
+    frames_++;
+    return true;
+}
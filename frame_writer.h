@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Writes rendered RGBA frames as a numbered image sequence or as raw video
+// to an encoder's stdin, e.g.
+//   ffmpeg -f rawvideo -pix_fmt rgba -s 1200x800 -r 60 -i - out.mp4
+// PNGs are written with stored (uncompressed) deflate blocks so no zlib is
+// needed; re-encode them or pipe to an encoder when size matters.
+class FrameWriter {
+public:
+    ~FrameWriter();
+
+    // pattern holds a printf int conversion for the frame number, such as
+    // "frames/%05d.png"; a .png extension writes PNG, anything else binary PPM
+    bool openSequence(const std::string& pattern);
+    // command is started with popen and receives width * height * 4 bytes per frame
+    bool openPipe(const std::string& command);
+    void close();
+    bool isOpen() const { return pipe_ != nullptr || !pattern_.empty(); }
+
+    bool write(const uint8_t* rgba, int width, int height);
+    uint64_t frames() const { return frames_; }
+
+private:
+    bool writePng(FILE* out, const uint8_t* rgba, int width, int height);
+    bool writePpm(FILE* out, const uint8_t* rgba, int width, int height);
+
+    std::string pattern_;
+    bool png_ = false;
+    FILE* pipe_ = nullptr;
+    uint64_t frames_ = 0;
+    std::vector<uint8_t> scratch_;
+};
@@ -0,0 +1,181 @@
+#include "inspector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "simulation.h"
+#include "spatial.h"
+
+// Drags shorter than this are treated as clicks
+static const float CLICK_SLOP = 4.0f;
+
+bool Inspector::locate(const World& w, Tracked& t) {
+    if (t.index < w.particles.size() && w.particles[t.index].id == t.id) return true;
+
+    // Steps, edits and removals are the only ways indices shift, so one map
+    // per world state serves every tracked particle that moved
+    if (w.step != indexedStep_ || w.edits != indexedEdits_ || w.particles.size() != indexOf_.size()) {
+        indexOf_.clear();
+        indexOf_.reserve(w.particles.size());
+        for (size_t i = 0; i < w.particles.size(); ++i) indexOf_.emplace(w.particles[i].id, i);
+        indexedStep_ = w.step;
+        indexedEdits_ = w.edits;
+    }
+    auto it = indexOf_.find(t.id);
+    if (it == indexOf_.end()) return false;
+    t.index = it->second;
+    return true;
+}
+
+void Inspector::inspect(const World& w, size_t index) {
+    inspecting_ = true;
+    inspected_ = {w.particles[index].id, index};
+}
+
+void Inspector::handleMouse(World& w) {
+    ImGuiIO& io = ImGui::GetIO();
+    if (!dragging_ && io.WantCaptureMouse) return;
+
+    if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+        dragging_ = true;
+        dragStart_ = io.MousePos;
+    }
+    if (!dragging_ || !ImGui::IsMouseReleased(ImGuiMouseButton_Left)) return;
+    dragging_ = false;
+
+    ImVec2 end = io.MousePos;
+    if (!io.KeyShift) selected_.clear();
+
+    if (std::fabs(end.x - dragStart_.x) < CLICK_SLOP && std::fabs(end.y - dragStart_.y) < CLICK_SLOP) {
+        int64_t hit = pickParticle(w, end.x, end.y);
+        if (hit < 0) {
+            inspecting_ = false;
+            return;
+        }
+        inspect(w, static_cast<size_t>(hit));
+        if (io.KeyShift) selected_.push_back(inspected_);
+        return;
+    }
+
+    queryRect(w, dragStart_.x, dragStart_.y, end.x, end.y, scratch_);
+    for (uint32_t i : scratch_) {
+        uint32_t id = w.particles[i].id;
+        bool known = std::any_of(selected_.begin(), selected_.end(), [&](const Tracked& t) { return t.id == id; });
+        if (!known) selected_.push_back({id, i});
+    }
+    if (scratch_.size() == 1) inspect(w, scratch_[0]);
+}
+
+void Inspector::drawOverlay(World& w) {
+    ImDrawList* draw_list = ImGui::GetBackgroundDrawList();
+
+    // Drop particles that no longer exist
+    selected_.erase(std::remove_if(selected_.begin(), selected_.end(), [&](Tracked& t) { return !locate(w, t); }),
+                    selected_.end());
+    for (const Tracked& t : selected_) {
+        const Particle& p = w.particles[t.index];
+        draw_list->AddCircle(ImVec2(p.x, p.y), p.size + 2.0f, IM_COL32(255, 220, 0, 255), 0, 1.5f);
+    }
+
+    if (inspecting_ && locate(w, inspected_)) {
+        const Particle& p = w.particles[inspected_.index];
+        draw_list->AddCircle(ImVec2(p.x, p.y), p.size + 4.0f, IM_COL32(255, 255, 255, 255), 0, 2.0f);
+    }
+
+    if (dragging_) {
+        ImVec2 now = ImGui::GetIO().MousePos;
+        draw_list->AddRect(dragStart_, now, IM_COL32(255, 220, 0, 255));
+    }
+}
+
+void Inspector::drawWindows(World& w) {
+    ImGui::Begin("Inspector");
+
+    if (!inspecting_) {
+        ImGui::TextUnformatted("Click a particle to inspect it, drag to select");
+    } else if (!locate(w, inspected_)) {
+        ImGui::Text("Particle #%u no longer exists", inspected_.id);
+    } else {
+        Particle& p = w.particles[inspected_.index];
+        ImGui::Text("Particle #%u  (index %zu)", p.id, inspected_.index);
+        ImGui::Text("Species     %s (%u)", p.name.c_str(), static_cast<unsigned>(p.species));
+        ImGui::Text("Position    %.1f, %.1f", p.x, p.y);
+        ImGui::Text("Velocity    %.3f, %.3f  (speed %.3f)", p.vx, p.vy, std::sqrt(p.vx * p.vx + p.vy * p.vy));
+        ImGui::Text("Size        %.2f", p.size);
+        if (p.size >= DECAY_SIZE) {
+            int period = p.decay_time > 0 ? p.decay_time : DEFAULT_DECAY_SECONDS;
+            ImGui::Text("Decay       every %d s, next in %d steps (%.1f s)", period, p.decay_countdown,
+                        static_cast<float>(p.decay_countdown) / STEPS_PER_SECOND);
+        } else {
+            ImGui::Text("Decay       stable (below size %.0f)", DECAY_SIZE);
+        }
+        ImGui::Text("Born        step %llu", static_cast<unsigned long long>(p.born_step));
+        if (ImGui::Checkbox("Frozen", &p.frozen)) w.edits++;
+
+        // Merge history: parents can be inspected in turn while they still exist
+        ImGui::Separator();
+        if (p.parents[0] == 0) {
+            ImGui::TextUnformatted("Not a reaction product");
+        } else {
+            ImGui::Text("Formed from %s #%u + %s #%u", speciesName(p.parent_species[0]).c_str(), p.parents[0],
+                        speciesName(p.parent_species[1]).c_str(), p.parents[1]);
+            for (int k = 0; k < 2; ++k) {
+                Tracked parent{p.parents[k], 0};
+                if (!locate(w, parent)) continue;
+                ImGui::PushID(k);
+                if (ImGui::Button("Inspect parent")) inspect(w, parent.index);
+                ImGui::SameLine();
+                ImGui::Text("#%u", parent.id);
+                ImGui::PopID();
+            }
+        }
+    }
+
+    // === Bulk operations on the box selection ===
+    ImGui::Separator();
+    ImGui::Text("%zu selected", selected_.size());
+    if (!selected_.empty()) {
+        scratch_.clear();
+        for (Tracked& t : selected_) {
+            if (locate(w, t)) scratch_.push_back(static_cast<uint32_t>(t.index));
+        }
+
+        if (ImGui::Button("Delete")) {
+            removeParticles(w, scratch_);
+            selected_.clear();
+            scratch_.clear();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Freeze")) {
+            for (uint32_t i : scratch_) w.particles[i].frozen = true;
+            w.edits++;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Unfreeze")) {
+            for (uint32_t i : scratch_) w.particles[i].frozen = false;
+            w.edits++;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear")) selected_.clear();
+
+        // Species picker, filtered by name
+        ImGui::InputText("Filter", filter_, sizeof(filter_));
+        if (ImGui::BeginCombo("Species", speciesName(static_cast<uint16_t>(speciesChoice_)).c_str())) {
+            for (size_t s = 0; s < speciesCount(); ++s) {
+                const std::string& name = speciesName(static_cast<uint16_t>(s));
+                if (filter_[0] != '\0' && name.find(filter_) == std::string::npos) continue;
+                if (ImGui::Selectable(name.c_str(), speciesChoice_ == static_cast<int>(s))) {
+                    speciesChoice_ = static_cast<int>(s);
+                }
+            }
+            ImGui::EndCombo();
+        }
+        if (ImGui::Button("Change species")) {
+            for (uint32_t i : scratch_) setSpecies(w.particles[i], static_cast<uint16_t>(speciesChoice_));
+            w.gridFresh = false;
+            w.edits++;
+        }
+    }
+
+    ImGui::End();
+}
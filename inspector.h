@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "imgui.h"
+
+struct World;
+
+// Mouse picking, box selection and the inspector window. Particles are
+// tracked by id, so a selection survives particles being added or removed.
+class Inspector {
+public:
+    // Click picks a particle, drag selects a box (shift adds to the selection)
+    void handleMouse(World& w);
+    // Highlights the inspected and selected particles and the box being dragged
+    void drawOverlay(World& w);
+    // Inspector and bulk-operation windows
+    void drawWindows(World& w);
+
+private:
+    struct Tracked {
+        uint32_t id;
+        size_t index; // Last known index, re-checked against the id before use
+    };
+
+    bool locate(const World& w, Tracked& t);
+    void inspect(const World& w, size_t index);
+
+    bool inspecting_ = false;
+    Tracked inspected_{0, 0};
+    std::vector<Tracked> selected_;
+
+    bool dragging_ = false;
+    ImVec2 dragStart_;
+
+    int speciesChoice_ = 0;
+    char filter_[32] = "";
+    std::vector<uint32_t> scratch_;
+
+    // Id -> index, for the world state it was built from
+    std::unordered_map<uint32_t, size_t> indexOf_;
+    uint64_t indexedStep_ = UINT64_MAX;
+    uint64_t indexedEdits_ = 0;
+};
@@ -0,0 +1,80 @@
+#include "observables.h"
+
+#include <cmath>
+#include "simulation.h"
+
+void reduceObservables(const std::vector<ObservablePartial>& parts, size_t chunks, StepObservables& out) {
+    out.particles = 0;
+    out.kineticEnergy = out.momentumX = out.momentumY = 0.0;
+    out.decays = 0;
+    out.trailPoints = 0;
+    out.asleep = 0;
+    out.population.assign(speciesCount(), 0);
+
+    for (size_t c = 0; c < chunks; ++c) {
+        const ObservablePartial& p = parts[c];
+        out.particles += p.particles;
+        out.kineticEnergy += p.kineticEnergy;
+        out.momentumX += p.momentumX;
+        out.momentumY += p.momentumY;
+        out.decays += p.decays;
+        out.trailPoints += p.trailPoints;
+        out.asleep += p.asleep;
+        for (size_t s = 0; s < p.population.size(); ++s) {
+            out.population[s] += p.population[s];
+        }
+    }
+}
+
+ObservablesRecorder::ObservablesRecorder() {
+    for (auto& h : history_) h.assign(HISTORY, 0.0f);
+}
+
+ObservablesRecorder::~ObservablesRecorder() {
+    closeCsv();
+}
+
+bool ObservablesRecorder::openCsv(const std::string& path, unsigned every) {
+    closeCsv();
+    csv_ = std::fopen(path.c_str(), "w");
+    if (!csv_) return false;
+    every_ = every > 0 ? every : 1;
+    // Species populations go in one quoted column as name=count pairs separated by ';'
+    std::fprintf(csv_, "step,particles,kinetic_energy,momentum_x,momentum_y,collisions,merges,decays,"
+                       "trail_points,mean_trail_length,asleep,allocations,species\n");
+    return true;
+}
+
+void ObservablesRecorder::closeCsv() {
+    if (csv_) std::fclose(csv_);
+    csv_ = nullptr;
+}
+
+void ObservablesRecorder::record(const StepObservables& o) {
+    latest_ = o;
+
+    history_[Particles][next_] = static_cast<float>(o.particles);
+    history_[KineticEnergy][next_] = static_cast<float>(o.kineticEnergy);
+    history_[Momentum][next_] = static_cast<float>(std::sqrt(o.momentumX * o.momentumX + o.momentumY * o.momentumY));
+    history_[Merges][next_] = static_cast<float>(o.merges);
+    history_[Decays][next_] = static_cast<float>(o.decays);
+    history_[TrailLength][next_] = static_cast<float>(o.meanTrailLength());
+    next_ = (next_ + 1) % HISTORY;
+    if (count_ < HISTORY) count_++;
+
+    if (csv_ && o.step % every_ == 0) {
+        std::fprintf(csv_, "%llu,%zu,%.6g,%.6g,%.6g,%llu,%llu,%llu,%zu,%.4g,%zu,%llu,\"",
+                     static_cast<unsigned long long>(o.step), o.particles, o.kineticEnergy,
+                     o.momentumX, o.momentumY, static_cast<unsigned long long>(o.collisions),
+                     static_cast<unsigned long long>(o.merges), static_cast<unsigned long long>(o.decays),
+                     o.trailPoints, o.meanTrailLength(), o.asleep, static_cast<unsigned long long>(o.allocations));
+        bool first = true;
+        for (size_t s = 0; s < o.population.size(); ++s) {
+            if (o.population[s] == 0) continue;
+            std::fprintf(csv_, "%s%s=%u", first ? "" : ";", speciesName(static_cast<uint16_t>(s)).c_str(),
+                         o.population[s]);
+            first = false;
+        }
+        std::fprintf(csv_, "\"\n");
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Statistics for one step, gathered inside the integration and collision
+// passes rather than by walking the particles again afterwards. Population,
+// energy, momentum and trail figures are sampled right after integration;
+// particles created during the step are added when they are appended.
+struct StepObservables {
+    uint64_t step = 0;
+    size_t particles = 0;
+    double kineticEnergy = 0.0;  // Sum of 0.5 * size * |v|^2 (size is the mass, as in mergeParticles)
+    double momentumX = 0.0;
+    double momentumY = 0.0;
+    uint64_t collisions = 0;     // Overlapping pairs this step
+    uint64_t merges = 0;         // Reactions this step
+    uint64_t decays = 0;         // Decays this step
+    size_t trailPoints = 0;
+    size_t asleep = 0;           // Sleeping particles (see SleepSettings)
+    uint64_t allocations = 0;    // Heap allocations by any thread during the step or event-driven advance
+    std::vector<uint32_t> population;  // Indexed by species id
+
+    double meanTrailLength() const {
+        return particles > 0 ? static_cast<double>(trailPoints) / particles : 0.0;
+    }
+};
+
+// Partial sums for one work chunk. Chunks are reduced in index order so the
+// totals do not depend on how many threads ran the pass.
+struct ObservablePartial {
+    size_t particles = 0;
+    double kineticEnergy = 0.0;
+    double momentumX = 0.0;
+    double momentumY = 0.0;
+    uint64_t decays = 0;
+    size_t trailPoints = 0;
+    size_t asleep = 0;
+    std::vector<uint32_t> population;
+
+    void reset(size_t species) {
+        particles = 0;
+        kineticEnergy = momentumX = momentumY = 0.0;
+        decays = 0;
+        trailPoints = 0;
+        asleep = 0;
+        population.assign(species, 0);
+    }
+};
+
+void reduceObservables(const std::vector<ObservablePartial>& parts, size_t chunks, StepObservables& out);
+
+// Keeps a rolling history of each series for plotting and optionally streams
+// every Kth step to a CSV file.
+class ObservablesRecorder {
+public:
+    enum Series {
+        Particles,
+        KineticEnergy,
+        Momentum,
+        Merges,
+        Decays,
+        TrailLength,
+        SERIES_COUNT
+    };
+
+    static const int HISTORY = 600;
+
+    ObservablesRecorder();
+    ~ObservablesRecorder();
+
+    bool openCsv(const std::string& path, unsigned every = 1);
+    void closeCsv();
+
+    void record(const StepObservables& o);
+
+    // Ring buffer of HISTORY samples; pass offset() as the PlotLines values_offset
+    const float* series(Series s) const { return history_[s].data(); }
+    int count() const { return count_; }
+    int offset() const { return count_ < HISTORY ? 0 : next_; }
+    const StepObservables& latest() const { return latest_; }
+
+private:
+    std::vector<float> history_[SERIES_COUNT];
+    int next_ = 0;
+    int count_ = 0;
+    StepObservables latest_;
+
+    FILE* csv_ = nullptr;
+    unsigned every_ = 1;
+};
@@ -0,0 +1,158 @@
+#include "options.h"
+
+#include <iostream>
+#include "simulation.h"
+
+void printUsage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [options]\n"
+        "  --mode=element|particle|both  --count=<n>     scenario (asked on stdin if omitted)\n"
+        "  --temperature=<t>  --friction=<f>             initial settings\n"
+        "  --sleep                                       skip particles that have settled (not with --event-driven)\n"
+        "  --broad-phase=grid|quadtree                   collision broad phase (default grid)\n"
+        "  --headless  --steps=<n>                       run without a window\n"
+        "  --threads=<n>                                 worker threads (default: all)\n"
+        "  --event-driven                                event-driven stepping for sparse gases\n"
+        "  --compact  --world=<w>x<h>                    headless 14-byte particles in a w x h px world\n"
+        "  --deterministic  --seed=<n>                   fixed seed, bitwise repeatable runs\n"
+        "  --hash-trace=<path>  --hash-every=<k>  --hash-particles\n"
+        "  --compare-hashes=<a>,<b>                      report the first divergent step\n"
+        "  --event-level=off|reactions|collisions  --event-log=<path|->  --event-format=text|binary\n"
+        "  --observables=<csv>  --observables-every=<k>\n"
+        "  --rewind-mb=<n>                               rewind buffer budget (default 64, 0 = off)\n"
+        "  --heat-cell=<px>                              enable the temperature field with this cell size\n"
+        "  --frames=<pattern.png|.ppm>  --frames-pipe=<command>  --frames-every=<k>\n"
+        "                                                render headless runs on the CPU\n"
+        "  --shm=<name>                                  publish each step to POSIX shared memory\n"
+        "  --sweep=<config>  --sweep-out=<results.csv|.json>\n";
+}
+
+// Matches "--name=value" and stores value
+static bool option(const std::string& arg, const char* name, std::string& value) {
+    std::string prefix = std::string(name) + "=";
+    if (arg.rfind(prefix, 0) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& out) {
+    bool seedGiven = false;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            std::string v;
+            if (option(arg, "--event-level", v)) {
+                if (!parseLogLevel(v, out.eventLevel)) {
+                    std::cerr << "Unknown event level: " << v << "\n";
+                    return false;
+                }
+            } else if (option(arg, "--event-log", v)) {
+                out.eventPath = v;
+            } else if (option(arg, "--event-format", v)) {
+                if (v == "binary") out.eventFormat = LogFormat::Binary;
+                else if (v == "text") out.eventFormat = LogFormat::Text;
+                else {
+                    std::cerr << "Unknown event format: " << v << "\n";
+                    return false;
+                }
+            } else if (option(arg, "--observables", v)) {
+                out.observablesPath = v;
+            } else if (option(arg, "--observables-every", v)) {
+                out.observablesEvery = static_cast<unsigned>(std::stoul(v));
+            } else if (option(arg, "--rewind-mb", v)) {
+                out.rewindMb = static_cast<unsigned>(std::stoul(v));
+            } else if (option(arg, "--heat-cell", v)) {
+                out.heatCell = std::stof(v);
+            } else if (option(arg, "--frames", v)) {
+                out.framesPattern = v;
+            } else if (option(arg, "--frames-pipe", v)) {
+                out.framesPipe = v;
+            } else if (option(arg, "--frames-every", v)) {
+                out.framesEvery = static_cast<unsigned>(std::stoul(v));
+            } else if (option(arg, "--shm", v)) {
+                out.shmName = v.empty() || v[0] == '/' ? v : "/" + v;
+            } else if (option(arg, "--sweep", v)) {
+                out.sweep.configPath = v;
+            } else if (option(arg, "--sweep-out", v)) {
+                out.sweep.outputPath = v;
+            } else if (option(arg, "--mode", v)) {
+                SpeciesList species;
+                if (!speciesForMode(v, species)) {
+                    std::cerr << "Unknown mode: " << v << " (expected element, particle or both)\n";
+                    return false;
+                }
+                out.mode = v;
+            } else if (option(arg, "--count", v)) {
+                out.count = std::stoul(v);
+            } else if (option(arg, "--temperature", v)) {
+                out.temperature = std::stof(v);
+            } else if (option(arg, "--friction", v)) {
+                out.friction = std::stof(v);
+            } else if (arg == "--sleep") {
+                out.sleep = true;
+            } else if (option(arg, "--broad-phase", v)) {
+                if (v == "grid") out.broadPhase = BroadPhase::Grid;
+                else if (v == "quadtree") out.broadPhase = BroadPhase::Quadtree;
+                else {
+                    std::cerr << "Unknown broad phase: " << v << " (expected grid or quadtree)\n";
+                    return false;
+                }
+            } else if (arg == "--headless") {
+                out.headless = true;
+            } else if (option(arg, "--steps", v)) {
+                out.steps = std::stoull(v);
+            } else if (option(arg, "--threads", v)) {
+                out.threads = static_cast<unsigned>(std::stoul(v));
+            } else if (arg == "--event-driven") {
+                out.eventDriven = true;
+            } else if (arg == "--compact") {
+                out.compact = true;
+                out.headless = true;
+            } else if (option(arg, "--world", v)) {
+                size_t x = v.find('x');
+                if (x == std::string::npos) {
+                    std::cerr << "--world expects <width>x<height>\n";
+                    return false;
+                }
+                out.compactWidth = std::stof(v.substr(0, x));
+                out.compactHeight = std::stof(v.substr(x + 1));
+            } else if (arg == "--deterministic") {
+                out.deterministic = true;
+            } else if (option(arg, "--seed", v)) {
+                out.seed = static_cast<uint32_t>(std::stoul(v));
+                seedGiven = true;
+            } else if (option(arg, "--hash-trace", v)) {
+                out.hashTrace = v;
+            } else if (option(arg, "--hash-every", v)) {
+                out.hashEvery = static_cast<unsigned>(std::stoul(v));
+            } else if (arg == "--hash-particles") {
+                out.hashParticles = true;
+            } else if (option(arg, "--compare-hashes", v)) {
+                size_t comma = v.find(',');
+                if (comma == std::string::npos) {
+                    std::cerr << "--compare-hashes expects <a>,<b>\n";
+                    return false;
+                }
+                out.compareA = v.substr(0, comma);
+                out.compareB = v.substr(comma + 1);
+            } else if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                return false;
+            } else {
+                std::cerr << "Unknown option: " << arg << "\n";
+                printUsage(argv[0]);
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid number in options\n";
+        return false;
+    }
+
+    if (seedGiven) out.deterministic = true;
+    if (out.hashEvery == 0) out.hashEvery = 1;
+    if (out.observablesEvery == 0) out.observablesEvery = 1;
+    if (out.framesEvery == 0) out.framesEvery = 1;
+    out.sweep.steps = out.steps;
+    out.sweep.threads = out.threads;
+    return true;
+}
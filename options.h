@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "collision.h"
+#include "event_log.h"
+#include "sweep.h"
+
+// Command-line options shared by the interactive and headless front ends
+struct Options {
+    // Event log
+    LogLevel eventLevel = LogLevel::Off;
+    std::string eventPath = "events.log";
+    LogFormat eventFormat = LogFormat::Text;
+
+    // Observables CSV
+    std::string observablesPath;
+    unsigned observablesEvery = 1;
+
+    // Rewind buffer budget in MiB, 0 disables recording
+    unsigned rewindMb = 64;
+
+    // Temperature field cell size in pixels, 0 leaves the field off
+    float heatCell = 0.0f;
+
+    // Headless frame export: numbered PNG/PPM files or raw RGBA piped to a command
+    std::string framesPattern;
+    std::string framesPipe;
+    unsigned framesEvery = 1;
+
+    // Shared-memory state publishing, off when empty
+    std::string shmName;
+
+    // Sweep mode (configPath set) also uses steps and threads below
+    SweepOptions sweep;
+
+    // Scenario; an empty mode or zero count is asked for on stdin in interactive mode
+    std::string mode;
+    size_t count = 0;
+    float temperature = 0.5f;
+    float friction = 0.0f;
+    bool sleep = false;  // Let settled particles sleep (SleepSettings)
+    BroadPhase broadPhase = BroadPhase::Grid;
+
+    // Run control
+    bool headless = false;
+    uint64_t steps = 1000;
+    unsigned threads = 0;  // 0 uses every hardware thread
+    bool eventDriven = false;  // EventDrivenEngine instead of updateParticles
+
+    // Compact mode: CompactWorld of compactWidth x compactHeight pixels, always headless
+    bool compact = false;
+    float compactWidth = 1200.0f, compactHeight = 800.0f;
+
+    // Reproducibility: a fixed seed makes a run bitwise repeatable
+    bool deterministic = false;
+    uint32_t seed = 1;
+    std::string hashTrace;
+    unsigned hashEvery = 1;
+    bool hashParticles = false;
+    std::string compareA, compareB;
+};
+
+// Returns false and prints a message on malformed or unknown options
+bool parseOptions(int argc, char** argv, Options& out);
+
+void printUsage(const char* argv0);
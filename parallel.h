@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker pool for the data-parallel passes of a step. The calling
+// thread takes part in every run, so a pool of size 1 has no workers and runs
+// everything inline.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // Calls task(i) for every i in [0, count) and returns when all calls are done
+    void run(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    void workerLoop();
+    void drain();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable finished_;
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t count_ = 0;
+    std::atomic<size_t> next_{0};
+    size_t active_ = 0;
+    uint64_t generation_ = 0;
+    bool stopping_ = false;
+};
+
+// Fixed work partition: chunk boundaries depend only on n, never on the
+// thread count, so per-chunk partial results reduced in chunk order give the
+// same answer on any machine.
+const size_t PARALLEL_CHUNK = 2048;
+
+inline size_t chunkCount(size_t n) {
+    return (n + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+}
+
+// Runs fn(begin, end, chunk) over [0, n) in PARALLEL_CHUNK pieces, serially when pool is null
+template <typename F>
+void parallelFor(ThreadPool* pool, size_t n, F&& fn) {
+    size_t chunks = chunkCount(n);
+    auto task = [&](size_t c) {
+        size_t begin = c * PARALLEL_CHUNK;
+        size_t end = begin + PARALLEL_CHUNK < n ? begin + PARALLEL_CHUNK : n;
+        fn(begin, end, c);
+    };
+    if (!pool || pool->size() == 1 || chunks <= 1) {
+        for (size_t c = 0; c < chunks; ++c) task(c);
+        return;
+    }
+    pool->run(chunks, task);
+}
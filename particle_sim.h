@@ -0,0 +1,107 @@
+/* C API of the simulation core, built as libparticle_sim.
+ *
+ * The API is plain C so it can be loaded from Python (ctypes/cffi) or any
+ * other language. Functions never throw; fallible calls return a ps_status
+ * and leave a message for ps_last_error().
+ *
+ * Field arrays are views straight into the world's particle records: data
+ * points at the first particle's field and consecutive particles are stride
+ * bytes apart. Nothing is copied, so a view stays valid only until the next
+ * call that steps the world or adds particles. Writes through a view change
+ * the simulation state; vx and vy are recomputed from init_vx and init_vy
+ * every step, so write the init_ fields to change velocities.
+ */
+#ifndef PARTICLE_SIM_H
+#define PARTICLE_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(PARTICLE_SIM_BUILD)
+#    define PS_API __declspec(dllexport)
+#  else
+#    define PS_API __declspec(dllimport)
+#  endif
+#else
+#  define PS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PS_API_VERSION 1
+
+typedef struct ps_world ps_world;
+
+typedef enum ps_status {
+    PS_OK = 0,
+    PS_ERROR_ARGUMENT = -1,  /* null world, unknown mode or species */
+    PS_ERROR_INTERNAL = -2   /* exception inside the core, see ps_last_error */
+} ps_status;
+
+typedef enum ps_field {
+    PS_FIELD_X,
+    PS_FIELD_Y,
+    PS_FIELD_VX,
+    PS_FIELD_VY,
+    PS_FIELD_INIT_VX,
+    PS_FIELD_INIT_VY,
+    PS_FIELD_SIZE,
+    PS_FIELD_R,
+    PS_FIELD_G,
+    PS_FIELD_B
+} ps_field;
+
+/* Strided view: element i is at (const char*)data + i * stride */
+typedef struct ps_array {
+    void* data;
+    size_t count;
+    size_t stride;
+} ps_array;
+
+/* Input record for ps_world_add_particles */
+typedef struct ps_particle_desc {
+    uint16_t species;   /* from ps_species_id */
+    float x, y;
+    float vx, vy;
+    float size;         /* <= 0 uses the species' listed radius */
+    float r, g, b;
+} ps_particle_desc;
+
+PS_API uint32_t ps_api_version(void);
+PS_API const char* ps_last_error(void);
+
+/* threads == 0 uses every hardware thread, 1 steps on the calling thread.
+ * Worlds with the same seed and particles evolve bitwise identically. */
+PS_API ps_world* ps_world_create(uint32_t seed, unsigned threads);
+PS_API void ps_world_destroy(ps_world* world);
+
+PS_API ps_status ps_world_step(ps_world* world, uint64_t steps);
+PS_API uint64_t ps_world_step_count(const ps_world* world);
+PS_API size_t ps_world_count(const ps_world* world);
+
+PS_API void ps_world_set_temperature(ps_world* world, float temperature);
+PS_API float ps_world_temperature(const ps_world* world);
+PS_API void ps_world_set_friction(ps_world* world, float friction);
+PS_API float ps_world_friction(const ps_world* world);
+
+/* Random particles as in the interactive prompt; mode is "element", "particle" or "both" */
+PS_API ps_status ps_world_add_random(ps_world* world, const char* mode, size_t count);
+PS_API ps_status ps_world_add_particles(ps_world* world, const ps_particle_desc* particles, size_t count);
+
+PS_API ps_array ps_world_field(ps_world* world, ps_field field);  /* float */
+PS_API ps_array ps_world_species(ps_world* world);                /* uint16_t */
+PS_API ps_array ps_world_ids(ps_world* world);                    /* uint32_t */
+
+/* Species ids are fixed for a given build */
+PS_API size_t ps_species_count(void);
+PS_API uint16_t ps_species_id(const char* name);   /* 0xFFFF when unknown */
+PS_API const char* ps_species_name(uint16_t species);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PARTICLE_SIM_H */
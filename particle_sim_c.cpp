@@ -0,0 +1,186 @@
+#include "particle_sim.h"
+
+#include <exception>
+#include <memory>
+#include <string>
+#include "parallel.h"
+#include "simulation.h"
+
+struct ps_world {
+    World world;
+    std::unique_ptr<ThreadPool> pool;
+
+    explicit ps_world(uint32_t seed) : world(seed) {}
+};
+
+static thread_local std::string lastError;
+
+static ps_status fail(ps_status status, const std::string& message) {
+    lastError = message;
+    return status;
+}
+
+// Keeps exceptions from crossing the C boundary
+template <typename Fn>
+static ps_status guarded(Fn&& fn) {
+    try {
+        return fn();
+    } catch (const std::exception& e) {
+        return fail(PS_ERROR_INTERNAL, e.what());
+    } catch (...) {
+        return fail(PS_ERROR_INTERNAL, "unknown exception");
+    }
+}
+
+static ps_array view(std::vector<Particle>& particles, size_t offset) {
+    if (particles.empty()) return {nullptr, 0, sizeof(Particle)};
+    char* base = reinterpret_cast<char*>(particles.data());
+    return {base + offset, particles.size(), sizeof(Particle)};
+}
+
+// Byte offset of a member inside the first particle record
+template <typename T>
+static size_t fieldOffset(const std::vector<Particle>& particles, T Particle::*member) {
+    const Particle& p = particles.front();
+    return reinterpret_cast<const char*>(&(p.*member)) - reinterpret_cast<const char*>(&p);
+}
+
+extern "C" {
+
+uint32_t ps_api_version(void) {
+    return PS_API_VERSION;
+}
+
+const char* ps_last_error(void) {
+    return lastError.c_str();
+}
+
+ps_world* ps_world_create(uint32_t seed, unsigned threads) {
+    try {
+        std::unique_ptr<ps_world> w(new ps_world(seed));
+        if (threads != 1) {
+            w->pool.reset(new ThreadPool(threads));
+            w->world.pool = w->pool.get();
+        }
+        return w.release();
+    } catch (const std::exception& e) {
+        lastError = e.what();
+        return nullptr;
+    }
+}
+
+void ps_world_destroy(ps_world* world) {
+    delete world;
+}
+
+ps_status ps_world_step(ps_world* world, uint64_t steps) {
+    if (!world) return fail(PS_ERROR_ARGUMENT, "null world");
+    return guarded([&] {
+        for (uint64_t i = 0; i < steps; ++i) updateParticles(world->world);
+        return PS_OK;
+    });
+}
+
+uint64_t ps_world_step_count(const ps_world* world) {
+    return world ? world->world.step : 0;
+}
+
+size_t ps_world_count(const ps_world* world) {
+    return world ? world->world.particles.size() : 0;
+}
+
+void ps_world_set_temperature(ps_world* world, float temperature) {
+    if (world) world->world.temperature = temperature;
+}
+
+float ps_world_temperature(const ps_world* world) {
+    return world ? world->world.temperature : 0.0f;
+}
+
+void ps_world_set_friction(ps_world* world, float friction) {
+    if (world) world->world.friction = friction;
+}
+
+float ps_world_friction(const ps_world* world) {
+    return world ? world->world.friction : 0.0f;
+}
+
+ps_status ps_world_add_random(ps_world* world, const char* mode, size_t count) {
+    if (!world || !mode) return fail(PS_ERROR_ARGUMENT, "null argument");
+    return guarded([&] {
+        SpeciesList species;
+        if (!speciesForMode(mode, species)) {
+            return fail(PS_ERROR_ARGUMENT, std::string("unknown mode: ") + mode);
+        }
+        initParticles(world->world, count, species);
+        return PS_OK;
+    });
+}
+
+ps_status ps_world_add_particles(ps_world* world, const ps_particle_desc* particles, size_t count) {
+    if (!world || (!particles && count > 0)) return fail(PS_ERROR_ARGUMENT, "null argument");
+    for (size_t i = 0; i < count; ++i) {
+        if (particles[i].species >= speciesCount()) {
+            return fail(PS_ERROR_ARGUMENT, "unknown species id " + std::to_string(particles[i].species));
+        }
+    }
+    return guarded([&] {
+        World& w = world->world;
+        w.particles.reserve(w.particles.size() + count);
+        for (size_t i = 0; i < count; ++i) {
+            const ps_particle_desc& d = particles[i];
+            Particle p = makeParticle(w, d.species, d.x, d.y, d.vx, d.vy, d.size);
+            p.r = d.r;
+            p.g = d.g;
+            p.b = d.b;
+            w.particles.push_back(std::move(p));
+        }
+        return PS_OK;
+    });
+}
+
+ps_array ps_world_field(ps_world* world, ps_field field) {
+    if (!world || world->world.particles.empty()) return {nullptr, 0, sizeof(Particle)};
+    std::vector<Particle>& particles = world->world.particles;
+    float Particle::*member = nullptr;
+    switch (field) {
+        case PS_FIELD_X: member = &Particle::x; break;
+        case PS_FIELD_Y: member = &Particle::y; break;
+        case PS_FIELD_VX: member = &Particle::vx; break;
+        case PS_FIELD_VY: member = &Particle::vy; break;
+        case PS_FIELD_INIT_VX: member = &Particle::init_vx; break;
+        case PS_FIELD_INIT_VY: member = &Particle::init_vy; break;
+        case PS_FIELD_SIZE: member = &Particle::size; break;
+        case PS_FIELD_R: member = &Particle::r; break;
+        case PS_FIELD_G: member = &Particle::g; break;
+        case PS_FIELD_B: member = &Particle::b; break;
+        default:
+            lastError = "unknown field";
+            return {nullptr, 0, sizeof(Particle)};
+    }
+    return view(particles, fieldOffset(particles, member));
+}
+
+ps_array ps_world_species(ps_world* world) {
+    if (!world || world->world.particles.empty()) return {nullptr, 0, sizeof(Particle)};
+    return view(world->world.particles, fieldOffset(world->world.particles, &Particle::species));
+}
+
+ps_array ps_world_ids(ps_world* world) {
+    if (!world || world->world.particles.empty()) return {nullptr, 0, sizeof(Particle)};
+    return view(world->world.particles, fieldOffset(world->world.particles, &Particle::id));
+}
+
+size_t ps_species_count(void) {
+    return speciesCount();
+}
+
+uint16_t ps_species_id(const char* name) {
+    return name ? speciesId(name) : UNKNOWN_SPECIES;
+}
+
+const char* ps_species_name(uint16_t species) {
+    return speciesName(species).c_str();
+}
+
+} // extern "C"
@@ -0,0 +1,46 @@
+#include "quality.h"
+
+#include <algorithm>
+
+// Level 0 is full quality; each level shortens trails, drops labels and coarsens the geometry
+static const RenderQuality LEVEL_TABLE[QualityGovernor::LEVELS] = {
+    {50, 100000, 0, 1},
+    {35, 2000, 16, 1},
+    {25, 500, 12, 2},
+    {15, 200, 10, 2},
+    {10, 50, 8, 3},
+    {5, 0, 6, 4},
+};
+
+// Frames to wait after a level change; long enough for the average to settle
+static const int COOLDOWN_FRAMES = 20;
+// Weight of the newest frame in the moving average
+static const float SMOOTHING = 0.1f;
+
+const RenderQuality& QualityGovernor::update(float updateMs, float renderMs) {
+    updateMs_ += SMOOTHING * (updateMs - updateMs_);
+    renderMs_ += SMOOTHING * (renderMs - renderMs_);
+
+    if (!enabled) {
+        if (level_ != 0) apply(0);
+        return quality_;
+    }
+    if (cooldown_ > 0) {
+        cooldown_--;
+        return quality_;
+    }
+
+    float frameMs = updateMs_ + renderMs_;
+    if (frameMs > targetMs && level_ < LEVELS - 1) {
+        apply(level_ + 1);
+    } else if (frameMs < headroom * targetMs && level_ > 0) {
+        apply(level_ - 1);
+    }
+    return quality_;
+}
+
+void QualityGovernor::apply(int level) {
+    level_ = std::clamp(level, 0, LEVELS - 1);
+    quality_ = LEVEL_TABLE[level_];
+    cooldown_ = COOLDOWN_FRAMES;
+}
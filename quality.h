@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+// Optional rendering work that can be traded for frame time
+struct RenderQuality {
+    size_t maxTrail = 50;      // Longest trail kept per particle (the speed-based clamp's upper bound)
+    size_t maxLabels = 100000; // Labels drawn per frame; spread evenly over the particles when exceeded
+    int circleSegments = 0;    // 0 lets ImGui tessellate circles from their radius
+    int trailStride = 1;       // Draw every n-th trail segment
+};
+
+// Frame-budget controller. It keeps a smoothed update + render time and steps
+// through fixed quality levels: one level coarser while over the target, one
+// level finer once the frame fits in headroom * target. A short cooldown after
+// each change lets the new level show up in the average before the next step.
+class QualityGovernor {
+public:
+    static const int LEVELS = 6;
+
+    bool enabled = true;
+    float targetMs = 1000.0f / 60.0f; // Update + render budget per frame
+    float headroom = 0.7f;            // Fraction of the budget below which quality is restored
+
+    // Feeds one frame's measured times and returns the quality to use next frame
+    const RenderQuality& update(float updateMs, float renderMs);
+
+    const RenderQuality& quality() const { return quality_; }
+    int level() const { return level_; }
+    float updateMs() const { return updateMs_; }
+    float renderMs() const { return renderMs_; }
+
+private:
+    void apply(int level);
+
+    RenderQuality quality_;
+    int level_ = 0;
+    int cooldown_ = 0;
+    float updateMs_ = 0.0f;
+    float renderMs_ = 0.0f;
+};
@@ -0,0 +1,325 @@
+#include "raster.h"
+
+#include <algorithm>
+#include <cmath>
+#include "parallel.h"
+#include "simulation.h"
+#include "temperature_field.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PARTICLE_SIM_AVX2 1
+#include <immintrin.h>
+#endif
+
+// Tile edge in pixels; a tile is rasterised by one worker
+static const int RASTER_TILE = 64;
+
+// Glyph cell of the label font: 5x7 pixels plus one column of spacing
+static const int GLYPH_WIDTH = 5;
+static const int GLYPH_HEIGHT = 7;
+static const int GLYPH_ADVANCE = 6;
+
+// Printable ASCII from ' ' to '~', five columns per glyph, bit 0 at the top
+static const uint8_t FONT_5X7[95][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x08, 0x2A, 0x1C, 0x2A, 0x08}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31}, {0x18, 0x14, 0x12, 0x7F, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00},
+    {0x00, 0x56, 0x36, 0x00, 0x00}, {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06}, {0x32, 0x49, 0x79, 0x41, 0x3E},
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01},
+    {0x3E, 0x41, 0x49, 0x49, 0x7A}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},
+    {0x46, 0x49, 0x49, 0x49, 0x31}, {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F},
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x07, 0x08, 0x70, 0x08, 0x07}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x00},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7F, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78},
+    {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20}, {0x38, 0x44, 0x44, 0x48, 0x7F},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x0C, 0x52, 0x52, 0x52, 0x3E},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00},
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78},
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0x7C, 0x14, 0x14, 0x14, 0x08},
+    {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+    {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C},
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x7F, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x08, 0x04, 0x08, 0x10, 0x08},
+};
+
+// dst = round((src * a + dst * (255 - a)) / 255) per channel. The division
+// is exact in 16 bits: (t + 128 + ((t + 128) >> 8)) >> 8 == round(t / 255).
+static inline uint8_t blendChannel(uint8_t dst, uint8_t src, unsigned a) {
+    unsigned t = src * a + dst * (255 - a) + 128;
+    return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+static inline void blendPixel(uint8_t* px, const uint8_t rgba[4], unsigned a) {
+    for (int c = 0; c < 4; ++c) px[c] = blendChannel(px[c], c == 3 ? 255 : rgba[c], a);
+}
+
+static void blendSpanScalar(uint8_t* px, int begin, int n, const uint8_t rgba[4], unsigned a) {
+    for (int i = begin; i < n; ++i) blendPixel(px + 4 * i, rgba, a);
+}
+
+#ifdef PARTICLE_SIM_AVX2
+// Eight pixels at a time, same integer operations as blendChannel
+__attribute__((target("avx2")))
+static int blendSpanAvx2(uint8_t* px, int n, const uint8_t rgba[4], unsigned a) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i src = _mm256_set_epi16(255, rgba[2], rgba[1], rgba[0], 255, rgba[2], rgba[1], rgba[0],
+                                         255, rgba[2], rgba[1], rgba[0], 255, rgba[2], rgba[1], rgba[0]);
+    const __m256i srcA = _mm256_add_epi16(_mm256_mullo_epi16(src, _mm256_set1_epi16(static_cast<short>(a))),
+                                          _mm256_set1_epi16(128));
+    const __m256i inv = _mm256_set1_epi16(static_cast<short>(255 - a));
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px + 4 * i));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inv), srcA);
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inv), srcA);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px + 4 * i), _mm256_packus_epi16(lo, hi));
+    }
+    return i;
+}
+#endif
+
+// Blends n pixels starting at px with a constant colour and alpha
+static void blendSpan(uint8_t* px, int n, const uint8_t rgba[4], unsigned a) {
+    if (n <= 0 || a == 0) return;
+    int done = 0;
+#ifdef PARTICLE_SIM_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) done = blendSpanAvx2(px, n, rgba, a);
+#endif
+    blendSpanScalar(px, done, n, rgba, a);
+}
+
+// Alpha of a partially covered pixel
+static inline unsigned coverage(uint8_t alpha, float cover) {
+    return static_cast<unsigned>(alpha * std::clamp(cover, 0.0f, 1.0f) + 0.5f);
+}
+
+void SoftwareRenderer::resize(int width, int height) {
+    width_ = std::max(width, 0);
+    height_ = std::max(height, 0);
+    tilesX_ = (width_ + RASTER_TILE - 1) / RASTER_TILE;
+    tilesY_ = (height_ + RASTER_TILE - 1) / RASTER_TILE;
+    pixels_.assign(static_cast<size_t>(width_) * height_ * 4, 0);
+}
+
+void SoftwareRenderer::add(Kind kind, float x0, float y0, float x1, float y1, const uint8_t rgba[4], uint32_t text) {
+    Primitive p{x0, y0, x1, y1, {rgba[0], rgba[1], rgba[2], rgba[3]}, kind, text};
+    int bx0, by0, bx1, by1;
+    if (rgba[3] != 0 && bounds(p, bx0, by0, bx1, by1)) prims_.push_back(p);
+}
+
+// Inclusive pixel bounds clipped to the framebuffer; false when nothing is visible
+bool SoftwareRenderer::bounds(const Primitive& p, int& bx0, int& by0, int& bx1, int& by1) const {
+    float x0, y0, x1, y1;
+    switch (p.kind) {
+    case RECT: x0 = p.x0; y0 = p.y0; x1 = p.x1; y1 = p.y1; break;
+    case LINE:
+        x0 = std::min(p.x0, p.x1) - 1.0f; x1 = std::max(p.x0, p.x1) + 1.0f;
+        y0 = std::min(p.y0, p.y1) - 1.0f; y1 = std::max(p.y0, p.y1) + 1.0f;
+        break;
+    case CIRCLE: x0 = p.x0 - p.x1 - 1.0f; x1 = p.x0 + p.x1 + 1.0f; y0 = p.y0 - p.x1 - 1.0f; y1 = p.y0 + p.x1 + 1.0f; break;
+    default: x0 = p.x0; y0 = p.y0; x1 = p.x0 + p.x1; y1 = p.y0 + p.y1; break;
+    }
+    if (!(x1 >= 0.0f && y1 >= 0.0f && x0 < width_ && y0 < height_)) return false;  // Also rejects NaN
+    bx0 = std::max(static_cast<int>(std::floor(x0)), 0);
+    by0 = std::max(static_cast<int>(std::floor(y0)), 0);
+    bx1 = std::min(static_cast<int>(std::floor(x1)), width_ - 1);
+    by1 = std::min(static_cast<int>(std::floor(y1)), height_ - 1);
+    return true;
+}
+
+// Counting sort of primitive indices by tile, keeping draw order within a tile
+void SoftwareRenderer::bin() {
+    size_t tiles = static_cast<size_t>(tilesX_) * tilesY_;
+    tileStart_.assign(tiles + 1, 0);
+    std::vector<uint32_t> fill;
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass == 1) {
+            for (size_t t = 0; t < tiles; ++t) tileStart_[t + 1] += tileStart_[t];
+            tileItems_.resize(tileStart_[tiles]);
+            fill.assign(tileStart_.begin(), tileStart_.end() - 1);
+        }
+        for (size_t i = 0; i < prims_.size(); ++i) {
+            int bx0, by0, bx1, by1;
+            bounds(prims_[i], bx0, by0, bx1, by1);
+            for (int ty = by0 / RASTER_TILE; ty <= by1 / RASTER_TILE; ++ty) {
+                for (int tx = bx0 / RASTER_TILE; tx <= bx1 / RASTER_TILE; ++tx) {
+                    size_t t = static_cast<size_t>(ty) * tilesX_ + tx;
+                    if (pass == 0) tileStart_[t + 1]++;
+                    else tileItems_[fill[t]++] = static_cast<uint32_t>(i);
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRenderer::drawTile(const World& w, size_t tile) {
+    int tx0 = static_cast<int>(tile % tilesX_) * RASTER_TILE;
+    int ty0 = static_cast<int>(tile / tilesX_) * RASTER_TILE;
+    int tx1 = std::min(tx0 + RASTER_TILE, width_);  // Exclusive
+    int ty1 = std::min(ty0 + RASTER_TILE, height_);
+    auto row = [&](int y) { return &pixels_[(static_cast<size_t>(y) * width_) * 4]; };
+
+    // Opaque black, as the window clears to
+    for (int y = ty0; y < ty1; ++y) {
+        uint8_t* px = row(y);
+        for (int x = tx0; x < tx1; ++x) {
+            px[4 * x] = px[4 * x + 1] = px[4 * x + 2] = 0;
+            px[4 * x + 3] = 255;
+        }
+    }
+
+    for (uint32_t k = tileStart_[tile]; k < tileStart_[tile + 1]; ++k) {
+        const Primitive& p = prims_[tileItems_[k]];
+        int bx0, by0, bx1, by1;
+        bounds(p, bx0, by0, bx1, by1);
+        bx0 = std::max(bx0, tx0);
+        by0 = std::max(by0, ty0);
+        bx1 = std::min(bx1, tx1 - 1);
+        by1 = std::min(by1, ty1 - 1);
+
+        switch (p.kind) {
+        case RECT: {
+            // Pixels whose centre lies inside, without anti-aliasing
+            int x0 = std::max(static_cast<int>(std::ceil(p.x0 - 0.5f)), tx0);
+            int x1 = std::min(static_cast<int>(std::ceil(p.x1 - 0.5f)), tx1);
+            int y0 = std::max(static_cast<int>(std::ceil(p.y0 - 0.5f)), ty0);
+            int y1 = std::min(static_cast<int>(std::ceil(p.y1 - 0.5f)), ty1);
+            for (int y = y0; y < y1; ++y) blendSpan(row(y) + 4 * x0, x1 - x0, p.rgba, p.rgba[3]);
+            break;
+        }
+        case LINE: {
+            // One pixel wide, coverage falling off linearly with distance from the segment
+            float dx = p.x1 - p.x0, dy = p.y1 - p.y0;
+            float lengthSq = dx * dx + dy * dy;
+            for (int y = by0; y <= by1; ++y) {
+                uint8_t* px = row(y);
+                for (int x = bx0; x <= bx1; ++x) {
+                    float qx = x + 0.5f - p.x0, qy = y + 0.5f - p.y0;
+                    float t = lengthSq > 0.0f ? std::clamp((qx * dx + qy * dy) / lengthSq, 0.0f, 1.0f) : 0.0f;
+                    float ex = qx - t * dx, ey = qy - t * dy;
+                    unsigned a = coverage(p.rgba[3], 1.0f - std::sqrt(ex * ex + ey * ey));
+                    if (a != 0) blendPixel(px + 4 * x, p.rgba, a);
+                }
+            }
+            break;
+        }
+        case CIRCLE: {
+            // Per row: the span whose pixel centres lie at least half a pixel
+            // inside is fully covered; the fringe out to half a pixel outside
+            // is shaded by distance from the edge
+            float r = p.x1;
+            for (int y = by0; y <= by1; ++y) {
+                float cy = y + 0.5f - p.y0;
+                float outerSq = (r + 0.5f) * (r + 0.5f) - cy * cy;
+                if (outerSq <= 0.0f) continue;
+                float outer = std::sqrt(outerSq);
+                int o0 = std::max(static_cast<int>(std::floor(p.x0 - outer)), bx0);
+                int o1 = std::min(static_cast<int>(std::floor(p.x0 + outer)), bx1);
+                int f0 = o1 + 1, f1 = o1;
+                float innerSq = r > 0.5f ? (r - 0.5f) * (r - 0.5f) - cy * cy : -1.0f;
+                if (innerSq >= 0.0f) {
+                    float inner = std::sqrt(innerSq);
+                    f0 = std::clamp(static_cast<int>(std::ceil(p.x0 - inner - 0.5f)), o0, o1 + 1);
+                    f1 = std::clamp(static_cast<int>(std::floor(p.x0 + inner - 0.5f)), f0 - 1, o1);
+                }
+                uint8_t* px = row(y);
+                auto fringe = [&](int x) {
+                    float cx = x + 0.5f - p.x0;
+                    unsigned a = coverage(p.rgba[3], r + 0.5f - std::sqrt(cx * cx + cy * cy));
+                    if (a != 0) blendPixel(px + 4 * x, p.rgba, a);
+                };
+                for (int x = o0; x < f0; ++x) fringe(x);
+                blendSpan(px + 4 * f0, f1 - f0 + 1, p.rgba, p.rgba[3]);
+                for (int x = f1 + 1; x <= o1; ++x) fringe(x);
+            }
+            break;
+        }
+        case TEXT: {
+            int left = static_cast<int>(std::floor(p.x0));
+            int top = static_cast<int>(std::floor(p.y0));
+            const std::string& text = w.particles[p.text].name;
+            for (size_t c = 0; c < text.size(); ++c) {
+                int gx = left + static_cast<int>(c) * GLYPH_ADVANCE;
+                if (gx > bx1 || gx + GLYPH_WIDTH <= bx0) continue;
+                unsigned ch = static_cast<unsigned char>(text[c]);
+                const uint8_t* glyph = FONT_5X7[ch >= 32 && ch < 127 ? ch - 32 : '?' - 32];
+                for (int col = 0; col < GLYPH_WIDTH; ++col) {
+                    int x = gx + col;
+                    if (x < bx0 || x > bx1) continue;
+                    for (int bit = 0; bit < GLYPH_HEIGHT; ++bit) {
+                        int y = top + bit;
+                        if (y >= by0 && y <= by1 && (glyph[col] >> bit & 1)) blendPixel(row(y) + 4 * x, p.rgba, p.rgba[3]);
+                    }
+                }
+            }
+            break;
+        }
+        }
+    }
+}
+
+void SoftwareRenderer::render(const World& w, const RenderQuality& quality) {
+    if (pixels_.empty()) return;
+    prims_.clear();
+
+    if (showField && w.heat.enabled()) {
+        float s = w.heat.cellSize();
+        for (int cy = 0; cy < w.heat.rows(); ++cy) {
+            for (int cx = 0; cx < w.heat.cols(); ++cx) {
+                uint8_t tint[4];
+                temperatureTint(w.heat.at(cx, cy), tint);
+                add(RECT, cx * s, cy * s, (cx + 1) * s, (cy + 1) * s, tint);
+            }
+        }
+    }
+
+    // Trails and circles in the same order and colours as ParticleRenderer
+    size_t trailStride = static_cast<size_t>(std::max(quality.trailStride, 1));
+    for (const Particle& p : w.particles) {
+        uint8_t color[4] = {static_cast<uint8_t>(p.r * 255), static_cast<uint8_t>(p.g * 255),
+                            static_cast<uint8_t>(p.b * 255), 255};
+        for (size_t i = trailStride; i < p.trail.size(); i += trailStride) {
+            const TrailPoint& prev = p.trail[i - trailStride];
+            const TrailPoint& curr = p.trail[i];
+            uint8_t faded[4] = {color[0], color[1], color[2], static_cast<uint8_t>(curr.alpha * 255)};
+            add(LINE, prev.x, prev.y, curr.x, curr.y, faded);
+        }
+        add(CIRCLE, p.x, p.y, p.size, 0.0f, color);
+    }
+
+    size_t n = w.particles.size();
+    if (quality.maxLabels > 0) {
+        const uint8_t white[4] = {255, 255, 255, 255};
+        size_t labelStride = std::max<size_t>(1, (n + quality.maxLabels - 1) / quality.maxLabels);
+        for (size_t i = 0; i < n; i += labelStride) {
+            const Particle& p = w.particles[i];
+            float width = static_cast<float>(p.name.size() * GLYPH_ADVANCE);
+            add(TEXT, std::floor(p.x - width / 2), std::floor(p.y - GLYPH_HEIGHT / 2.0f), width,
+                static_cast<float>(GLYPH_HEIGHT), white, static_cast<uint32_t>(i));
+        }
+    }
+
+    bin();
+    size_t tiles = static_cast<size_t>(tilesX_) * tilesY_;
+    if (!w.pool || w.pool->size() == 1) {
+        for (size_t t = 0; t < tiles; ++t) drawTile(w, t);
+    } else {
+        w.pool->run(tiles, [&](size_t t) { drawTile(w, t); });
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "quality.h"
+
+struct World;
+
+// CPU rasteriser for headless frame export. It draws the layers the window
+// shows (temperature field tint, trails, circles, labels) into an RGBA8
+// framebuffer with no OpenGL context. Primitives are binned into square
+// tiles and each tile is rasterised by one worker in draw order, so the
+// image is identical on any thread count. Circles are scan-converted row by
+// row: anti-aliased edge pixels are shaded one at a time, the covered span
+// between them by a blend kernel (AVX2 or scalar, exact integer maths).
+// Labels use a built-in 5x7 bitmap font.
+class SoftwareRenderer {
+public:
+    bool showField = true;  // Tint temperature field cells when the field is enabled
+
+    void resize(int width, int height);
+    int width() const { return width_; }
+    int height() const { return height_; }
+    // Row-major R, G, B, A bytes from the top-left corner
+    const uint8_t* pixels() const { return pixels_.data(); }
+
+    // Draws w on the world's pool
+    void render(const World& w, const RenderQuality& quality);
+
+private:
+    enum Kind : uint8_t { RECT, LINE, CIRCLE, TEXT };
+
+    // RECT x0, y0 to x1, y1; LINE x0, y0 to x1, y1; CIRCLE centre x0, y0, radius x1;
+    // TEXT top-left x0, y0, size x1 by y1, characters of particle text
+    struct Primitive {
+        float x0, y0, x1, y1;
+        uint8_t rgba[4];
+        Kind kind;
+        uint32_t text;
+    };
+
+    void add(Kind kind, float x0, float y0, float x1, float y1, const uint8_t rgba[4], uint32_t text = 0);
+    bool bounds(const Primitive& p, int& bx0, int& by0, int& bx1, int& by1) const;
+    void bin();
+    void drawTile(const World& w, size_t tile);
+
+    int width_ = 0;
+    int height_ = 0;
+    int tilesX_ = 0;
+    int tilesY_ = 0;
+    std::vector<uint8_t> pixels_;
+    std::vector<Primitive> prims_;
+    std::vector<uint32_t> tileStart_;  // Per tile, offset into tileItems_ (tiles + 1 entries)
+    std::vector<uint32_t> tileItems_;  // Primitive indices, in draw order within each tile
+};
@@ -0,0 +1,97 @@
+#include "render.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "parallel.h"
+#include "simulation.h"
+#include "temperature_field.h"
+
+// Particles per draw-list block; a block's geometry is built by one worker
+static const size_t RENDER_BLOCK = 256;
+
+static void drawParticle(ImDrawList* list, const Particle& p, const RenderQuality& quality, size_t trailStride) {
+    // Draw trail
+    for (size_t i = trailStride; i < p.trail.size(); i += trailStride) {
+        auto& prev = p.trail[i - trailStride];
+        auto& curr = p.trail[i];
+        ImU32 faded = IM_COL32(p.r * 255, p.g * 255, p.b * 255, static_cast<int>(curr.alpha * 255));
+        list->AddLine(ImVec2(prev.x, prev.y), ImVec2(curr.x, curr.y), faded, 1.0f);
+    }
+
+    // Draw circle
+    ImU32 color = IM_COL32(p.r * 255, p.g * 255, p.b * 255, 255);
+    list->AddCircleFilled(ImVec2(p.x, p.y), p.size, color, quality.circleSegments);
+}
+
+// Appends src's vertices and indices to dst under dst's current clip rect and
+// texture. Commands that share a VtxOffset index into one run of vertices;
+// with 16-bit indices dst's PrimReserve starts a new VtxOffset when needed.
+static void appendGeometry(ImDrawList* dst, const ImDrawList& src) {
+    const ImVector<ImDrawCmd>& cmds = src.CmdBuffer;
+    for (int c = 0; c < cmds.Size;) {
+        int last = c;
+        unsigned int idxCount = cmds[c].ElemCount;
+        while (last + 1 < cmds.Size && cmds[last + 1].VtxOffset == cmds[c].VtxOffset) {
+            idxCount += cmds[++last].ElemCount;
+        }
+        unsigned int vtxBegin = cmds[c].VtxOffset;
+        unsigned int vtxEnd = last + 1 < cmds.Size ? cmds[last + 1].VtxOffset : static_cast<unsigned int>(src.VtxBuffer.Size);
+        int vtxCount = static_cast<int>(vtxEnd - vtxBegin);
+
+        if (idxCount > 0) {
+            dst->PrimReserve(static_cast<int>(idxCount), vtxCount);
+            ImDrawIdx base = static_cast<ImDrawIdx>(dst->_VtxCurrentIdx);
+            std::memcpy(dst->_VtxWritePtr, src.VtxBuffer.Data + vtxBegin, vtxCount * sizeof(ImDrawVert));
+            for (int k = c; k <= last; ++k) {
+                const ImDrawIdx* idx = src.IdxBuffer.Data + cmds[k].IdxOffset;
+                for (unsigned int i = 0; i < cmds[k].ElemCount; ++i) *dst->_IdxWritePtr++ = static_cast<ImDrawIdx>(base + idx[i]);
+            }
+            dst->_VtxWritePtr += vtxCount;
+            dst->_VtxCurrentIdx += vtxCount;
+        }
+        c = last + 1;
+    }
+}
+
+void ParticleRenderer::draw(ImDrawList* target, const World& w, const RenderQuality& quality) {
+    size_t trailStride = static_cast<size_t>(std::max(quality.trailStride, 1));
+    size_t n = w.particles.size();
+    size_t blocks = (n + RENDER_BLOCK - 1) / RENDER_BLOCK;
+
+    if (!parallel || !w.pool || w.pool->size() == 1 || blocks <= 1) {
+        for (const auto& p : w.particles) drawParticle(target, p, quality, trailStride);
+    } else {
+        while (blocks_.size() < blocks) blocks_.push_back(std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData()));
+        w.pool->run(blocks, [&](size_t b) {
+            ImDrawList* list = blocks_[b].get();
+            list->_ResetForNewFrame();
+            list->Flags = target->Flags;  // Same anti-aliasing and VtxOffset support as the target
+            size_t end = std::min(n, (b + 1) * RENDER_BLOCK);
+            for (size_t i = b * RENDER_BLOCK; i < end; ++i) drawParticle(list, w.particles[i], quality, trailStride);
+        });
+        for (size_t b = 0; b < blocks; ++b) appendGeometry(target, *blocks_[b]);
+    }
+
+    // Spread the label budget evenly instead of labelling only the first particles
+    if (quality.maxLabels == 0) return;
+    size_t labelStride = std::max<size_t>(1, (n + quality.maxLabels - 1) / quality.maxLabels);
+    for (size_t i = 0; i < n; i += labelStride) {
+        const Particle& p = w.particles[i];
+        ImVec2 text_size = ImGui::CalcTextSize(p.name.c_str());
+        target->AddText(ImVec2(p.x - text_size.x / 2, p.y - text_size.y / 2), IM_COL32(255, 255, 255, 255), p.name.c_str());
+    }
+}
+
+void drawTemperatureField(ImDrawList* target, const TemperatureField& field) {
+    float s = field.cellSize();
+    for (int cy = 0; cy < field.rows(); ++cy) {
+        for (int cx = 0; cx < field.cols(); ++cx) {
+            uint8_t tint[4];
+            temperatureTint(field.at(cx, cy), tint);
+            if (tint[3] == 0) continue;
+            target->AddRectFilled(ImVec2(cx * s, cy * s), ImVec2((cx + 1) * s, (cy + 1) * s),
+                                  IM_COL32(tint[0], tint[1], tint[2], tint[3]));
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "imgui.h"
+#include "quality.h"
+
+class TemperatureField;
+struct World;
+
+// Builds the particle layer (trails, circles, labels) into a draw list. With
+// a pool the particles are split into fixed blocks; each block tessellates
+// into its own ImDrawList on a worker, and the blocks' vertices and indices
+// are then appended to the target in particle order, so the output is the
+// same as the serial path. Labels are always added serially afterwards:
+// font lookups go through ImGui's shared font state.
+class ParticleRenderer {
+public:
+    bool parallel = true;
+
+    void draw(ImDrawList* target, const World& w, const RenderQuality& quality);
+
+private:
+    std::vector<std::unique_ptr<ImDrawList>> blocks_;
+};
+
+// Tints each temperature field cell red (above ambient) or blue (below)
+void drawTemperatureField(ImDrawList* target, const TemperatureField& field);
@@ -0,0 +1,314 @@
+#include "rewind.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include "simulation.h"
+
+// Quantisation steps per unit
+static const float POSITION_SCALE = 64.0f;
+static const float VELOCITY_SCALE = 4096.0f;
+static const float SIZE_SCALE = 256.0f;
+
+// Per-particle flag bits; the low three mirror QuantParticle::flags
+static const uint8_t FLAG_MERGED = 1;
+static const uint8_t FLAG_FROZEN = 2;
+static const uint8_t FLAG_ASLEEP = 4;
+static const uint8_t FLAG_HAS_PREV = 8;    // Same particle at the same index in the previous step
+static const uint8_t FLAG_SAME_META = 16;  // Only the motion fields changed
+
+static void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static uint64_t getVarint(const uint8_t*& p) {
+    uint64_t v = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+static uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+static int32_t quantize(float v, float scale) {
+    float q = v * scale;
+    if (!(q == q)) return 0;  // NaN
+    q = std::clamp(q, -2147483520.0f, 2147483520.0f);
+    return static_cast<int32_t>(std::lround(q));
+}
+
+static uint8_t quantizeColor(float c) {
+    return static_cast<uint8_t>(std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f));
+}
+
+// The standard streams the engine state as decimal words, which is portable within one library
+static void saveRng(const std::mt19937& rng, std::vector<uint32_t>& out) {
+    std::stringstream ss;
+    ss << rng;
+    out.clear();
+    uint64_t word;
+    while (ss >> word) out.push_back(static_cast<uint32_t>(word));
+}
+
+static void loadRng(std::mt19937& rng, const std::vector<uint32_t>& words) {
+    std::stringstream ss;
+    for (uint32_t word : words) ss << word << ' ';
+    ss >> rng;
+}
+
+static void capture(const World& w, RewindBuffer::QuantState& out) {
+    out.step = w.step;
+    out.nextId = w.nextId;
+    out.merges = w.merges;
+    out.decays = w.decays;
+    saveRng(w.rng, out.rng);
+    out.particles.resize(w.particles.size());
+    for (size_t i = 0; i < w.particles.size(); ++i) {
+        const Particle& p = w.particles[i];
+        RewindBuffer::QuantParticle& q = out.particles[i];
+        q.id = p.id;
+        q.species = p.species;
+        q.flags = (p.merged ? FLAG_MERGED : 0) | (p.frozen ? FLAG_FROZEN : 0) | (p.asleep ? FLAG_ASLEEP : 0);
+        q.r = quantizeColor(p.r);
+        q.g = quantizeColor(p.g);
+        q.b = quantizeColor(p.b);
+        q.x = quantize(p.x, POSITION_SCALE);
+        q.y = quantize(p.y, POSITION_SCALE);
+        q.vx = quantize(p.vx, VELOCITY_SCALE);
+        q.vy = quantize(p.vy, VELOCITY_SCALE);
+        q.ivx = quantize(p.init_vx, VELOCITY_SCALE);
+        q.ivy = quantize(p.init_vy, VELOCITY_SCALE);
+        q.size = quantize(p.size, SIZE_SCALE);
+        q.decay_time = p.decay_time;
+        q.decay_countdown = p.decay_countdown;
+        q.still_steps = p.still_steps;
+        q.born_step = p.born_step;
+        q.parents[0] = p.parents[0];
+        q.parents[1] = p.parents[1];
+        q.parent_species[0] = p.parent_species[0];
+        q.parent_species[1] = p.parent_species[1];
+    }
+}
+
+static void apply(const RewindBuffer::QuantState& s, World& w) {
+    w.step = s.step;
+    w.nextId = static_cast<uint32_t>(s.nextId);
+    w.merges = s.merges;
+    w.decays = s.decays;
+    loadRng(w.rng, s.rng);
+    w.spawned.clear();
+    w.gridFresh = false;
+    w.edits++;
+    // The restored sleepers settled in the recorded timeline; only a change of
+    // temperature or friction since should wake them
+    w.settledEdits = w.edits;
+
+    w.particles.clear();
+    w.particles.reserve(s.particles.size());
+    for (const RewindBuffer::QuantParticle& q : s.particles) {
+        Particle p;
+        p.id = q.id;
+        p.species = q.species;
+        p.name = speciesName(q.species);
+        p.merged = q.flags & FLAG_MERGED;
+        p.frozen = q.flags & FLAG_FROZEN;
+        p.asleep = q.flags & FLAG_ASLEEP;
+        p.r = q.r / 255.0f;
+        p.g = q.g / 255.0f;
+        p.b = q.b / 255.0f;
+        p.x = q.x / POSITION_SCALE;
+        p.y = q.y / POSITION_SCALE;
+        p.vx = q.vx / VELOCITY_SCALE;
+        p.vy = q.vy / VELOCITY_SCALE;
+        p.init_vx = q.ivx / VELOCITY_SCALE;
+        p.init_vy = q.ivy / VELOCITY_SCALE;
+        p.size = q.size / SIZE_SCALE;
+        p.decay_time = q.decay_time;
+        p.decay_countdown = q.decay_countdown;
+        p.still_steps = q.still_steps;
+        p.born_step = q.born_step;
+        p.parents[0] = q.parents[0];
+        p.parents[1] = q.parents[1];
+        p.parent_species[0] = q.parent_species[0];
+        p.parent_species[1] = q.parent_species[1];
+        w.particles.push_back(std::move(p));
+    }
+}
+
+static bool sameMeta(const RewindBuffer::QuantParticle& a, const RewindBuffer::QuantParticle& b) {
+    return a.species == b.species && a.r == b.r && a.g == b.g && a.b == b.b && a.decay_time == b.decay_time &&
+           a.born_step == b.born_step && a.parents[0] == b.parents[0] && a.parents[1] == b.parents[1] &&
+           a.parent_species[0] == b.parent_species[0] && a.parent_species[1] == b.parent_species[1];
+}
+
+// Motion fields, delta-coded against the previous step
+#define REWIND_MOTION_FIELDS(F) F(x) F(y) F(vx) F(vy) F(ivx) F(ivy) F(size) F(decay_countdown) F(still_steps)
+
+static void encode(const RewindBuffer::QuantState& cur, const RewindBuffer::QuantState* prev, std::vector<uint8_t>& out) {
+    out.clear();
+    putVarint(out, cur.step);
+    putVarint(out, cur.nextId);
+    putVarint(out, cur.merges);
+    putVarint(out, cur.decays);
+
+    // RNG words change rarely between steps; XOR against the previous step codes unchanged words in one byte
+    bool rngDelta = prev && prev->rng.size() == cur.rng.size();
+    putVarint(out, cur.rng.size() << 1 | (rngDelta ? 1 : 0));
+    for (size_t i = 0; i < cur.rng.size(); ++i) putVarint(out, rngDelta ? cur.rng[i] ^ prev->rng[i] : cur.rng[i]);
+
+    putVarint(out, cur.particles.size());
+    for (size_t i = 0; i < cur.particles.size(); ++i) {
+        const RewindBuffer::QuantParticle& c = cur.particles[i];
+        const RewindBuffer::QuantParticle* p = nullptr;
+        if (prev && i < prev->particles.size() && prev->particles[i].id == c.id) p = &prev->particles[i];
+
+        uint8_t flags = c.flags;
+        if (p) flags |= FLAG_HAS_PREV;
+        if (p && sameMeta(c, *p)) flags |= FLAG_SAME_META;
+        out.push_back(flags);
+
+        if (!p) putVarint(out, c.id);
+        if (!(flags & FLAG_SAME_META)) {
+            putVarint(out, c.species);
+            out.push_back(c.r);
+            out.push_back(c.g);
+            out.push_back(c.b);
+            putVarint(out, zigzag(c.decay_time));
+            putVarint(out, c.born_step);
+            putVarint(out, c.parents[0]);
+            putVarint(out, c.parents[1]);
+            putVarint(out, c.parent_species[0]);
+            putVarint(out, c.parent_species[1]);
+        }
+#define F(field) putVarint(out, zigzag(static_cast<int64_t>(c.field) - (p ? p->field : 0)));
+        REWIND_MOTION_FIELDS(F)
+#undef F
+    }
+}
+
+// Decodes in place: state holds the previous step on entry (ignored for keyframes)
+static void decode(const std::vector<uint8_t>& bytes, RewindBuffer::QuantState& state) {
+    const uint8_t* in = bytes.data();
+    state.step = getVarint(in);
+    state.nextId = getVarint(in);
+    state.merges = getVarint(in);
+    state.decays = getVarint(in);
+
+    uint64_t rngHeader = getVarint(in);
+    size_t rngWords = rngHeader >> 1;
+    bool rngDelta = rngHeader & 1;
+    state.rng.resize(rngWords);
+    for (size_t i = 0; i < rngWords; ++i) {
+        uint32_t v = static_cast<uint32_t>(getVarint(in));
+        state.rng[i] = rngDelta ? state.rng[i] ^ v : v;
+    }
+
+    size_t count = getVarint(in);
+    if (state.particles.size() < count) state.particles.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        RewindBuffer::QuantParticle& q = state.particles[i];
+        uint8_t flags = *in++;
+        bool hasPrev = flags & FLAG_HAS_PREV;
+        q.flags = flags & (FLAG_MERGED | FLAG_FROZEN | FLAG_ASLEEP);
+
+        if (!hasPrev) q.id = static_cast<uint32_t>(getVarint(in));
+        if (!(flags & FLAG_SAME_META)) {
+            q.species = static_cast<uint16_t>(getVarint(in));
+            q.r = *in++;
+            q.g = *in++;
+            q.b = *in++;
+            q.decay_time = static_cast<int32_t>(unzigzag(getVarint(in)));
+            q.born_step = getVarint(in);
+            q.parents[0] = static_cast<uint32_t>(getVarint(in));
+            q.parents[1] = static_cast<uint32_t>(getVarint(in));
+            q.parent_species[0] = static_cast<uint16_t>(getVarint(in));
+            q.parent_species[1] = static_cast<uint16_t>(getVarint(in));
+        }
+#define F(field) q.field = static_cast<int32_t>(unzigzag(getVarint(in)) + (hasPrev ? q.field : 0));
+        REWIND_MOTION_FIELDS(F)
+#undef F
+    }
+    state.particles.resize(count);
+}
+
+#undef REWIND_MOTION_FIELDS
+
+void RewindBuffer::record(const World& w) {
+    if (budget_ == 0) return;
+
+    // Recording into the past branches the timeline: drop the stored future
+    if (!snapshots_.empty() && w.step <= snapshots_.back().step) {
+        while (!snapshots_.empty() && snapshots_.back().step >= w.step) {
+            bytes_ -= snapshots_.back().bytes.size();
+            snapshots_.pop_back();
+        }
+        if (!snapshots_.empty()) {
+            size_t key = snapshots_.size() - 1;
+            while (!snapshots_[key].key) key--;
+            for (size_t i = key; i < snapshots_.size(); ++i) decode(snapshots_[i].bytes, last_);
+        }
+    }
+
+    size_t sinceKey = 0;
+    for (auto it = snapshots_.rbegin(); it != snapshots_.rend() && !it->key; ++it) sinceKey++;
+    bool key = snapshots_.empty() || sinceKey + 1 >= KEYFRAME_INTERVAL;
+
+    capture(w, scratch_);
+    // Encoding reuses one buffer; the stored copy is the only allocation and fits exactly
+    encode(scratch_, key ? nullptr : &last_, encoded_);
+    snapshots_.push_back({w.step, key, std::vector<uint8_t>(encoded_.begin(), encoded_.end())});
+    bytes_ += snapshots_.back().bytes.size();
+    std::swap(last_, scratch_);
+    evict();
+}
+
+bool RewindBuffer::restore(World& w, uint64_t step) {
+    auto it = std::lower_bound(snapshots_.begin(), snapshots_.end(), step,
+                               [](const Snapshot& s, uint64_t v) { return s.step < v; });
+    if (it == snapshots_.end() || it->step != step) return false;
+
+    size_t index = it - snapshots_.begin();
+    size_t key = index;
+    while (!snapshots_[key].key) key--;
+    for (size_t i = key; i <= index; ++i) decode(snapshots_[i].bytes, scratch_);
+    apply(scratch_, w);
+    return true;
+}
+
+void RewindBuffer::clear() {
+    snapshots_.clear();
+    bytes_ = 0;
+    last_ = QuantState();
+}
+
+void RewindBuffer::setBudget(size_t bytes) {
+    budget_ = bytes;
+    if (budget_ == 0) clear();
+    evict();
+}
+
+void RewindBuffer::evict() {
+    // Whole keyframe groups go at once; the group holding the newest step always stays
+    while (bytes_ > budget_ && !snapshots_.empty()) {
+        size_t end = 1;
+        while (end < snapshots_.size() && !snapshots_[end].key) end++;
+        if (end == snapshots_.size()) break;
+        for (size_t i = 0; i < end; ++i) {
+            bytes_ -= snapshots_.front().bytes.size();
+            snapshots_.pop_front();
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+struct World;
+
+// In-memory history of recent steps for scrubbing back in time. Every step is
+// stored as a quantised snapshot: a keyframe every KEYFRAME_INTERVAL steps and
+// otherwise varint-coded deltas against the previous step, so a slowly moving
+// scene costs a few bytes per particle per step. The oldest keyframe group is
+// dropped whenever the total exceeds the memory budget.
+//
+// Restoring is lossy: positions are kept to 1/64 px, velocities to 1/4096 and
+// sizes to 1/256; colours to 8 bits. Trails are not stored and restart empty.
+// The simulation is deterministic from the restored state onwards.
+class RewindBuffer {
+public:
+    static const size_t KEYFRAME_INTERVAL = 60;
+
+    explicit RewindBuffer(size_t budgetBytes = 64u << 20) : budget_(budgetBytes) {}
+
+    // Appends the world's current step. Recording a step at or before the
+    // newest stored one discards the stored future first (the timeline branches).
+    void record(const World& w);
+
+    // Replaces the world's particles, step counter, ids, counters and RNG with a
+    // stored step; false if the step is not buffered
+    bool restore(World& w, uint64_t step);
+
+    void clear();
+    void setBudget(size_t bytes);
+    size_t budget() const { return budget_; }
+    size_t bytes() const { return bytes_; }
+
+    bool empty() const { return snapshots_.empty(); }
+    uint64_t oldestStep() const { return snapshots_.empty() ? 0 : snapshots_.front().step; }
+    uint64_t newestStep() const { return snapshots_.empty() ? 0 : snapshots_.back().step; }
+    size_t count() const { return snapshots_.size(); }
+
+    // Integer state of one step, what the snapshots encode
+    struct QuantParticle {
+        uint32_t id;
+        uint16_t species;
+        uint8_t flags;                // merged, frozen, asleep
+        uint8_t r, g, b;
+        int32_t x, y, vx, vy, ivx, ivy, size;
+        int32_t decay_time, decay_countdown;
+        uint32_t still_steps;
+        uint64_t born_step;
+        uint32_t parents[2];
+        uint16_t parent_species[2];
+    };
+    struct QuantState {
+        uint64_t step = 0, nextId = 0, merges = 0, decays = 0;
+        std::vector<uint32_t> rng;
+        std::vector<QuantParticle> particles;
+    };
+
+private:
+    struct Snapshot {
+        uint64_t step;
+        bool key;
+        std::vector<uint8_t> bytes;
+    };
+
+    void evict();
+
+    size_t budget_;
+    size_t bytes_ = 0;
+    std::deque<Snapshot> snapshots_;
+    QuantState last_;   // State of snapshots_.back(), the base of the next delta
+    QuantState scratch_;
+    std::vector<uint8_t> encoded_;  // Encoder output, copied into the snapshot
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Layout of the shared-memory state segment written by ShmPublisher and read
+// by ShmReader. Everything is little-endian and naturally aligned so tools in
+// other languages can map it directly:
+//
+//   ShmHeader
+//   species names: speciesCount * SHM_NAME_BYTES, NUL padded
+//   slot 0 arrays, slot 1 arrays (slot i at slotsOffset + i * shmSlotBytes(capacity))
+//
+// Each slot holds capacity entries of: float x[], y[], vx[], vy[], size[],
+// uint32_t id[], uint16_t species[], in that order, each array starting on a
+// 64-byte boundary (see shmArrayOffset). The writer fills the slot that is not
+// published, then flips front, so a reader has a whole step to use the front
+// slot in place. A slot's seq is odd while it is being written or while the
+// layout changes; readers check it is even before and unchanged after using
+// the data. When the capacity grows the segment is enlarged and readers remap.
+
+static const char SHM_MAGIC[8] = {'P', 'S', 'S', 'H', 'M', '0', '0', '1'};
+static const uint32_t SHM_VERSION = 1;
+static const size_t SHM_NAME_BYTES = 32;
+static const size_t SHM_ALIGN = 64;
+
+enum ShmArray : uint32_t { SHM_X, SHM_Y, SHM_VX, SHM_VY, SHM_SIZE, SHM_ID, SHM_SPECIES, SHM_ARRAYS };
+
+struct ShmSlot {
+    std::atomic<uint64_t> seq;   // Odd while the writer is filling this slot
+    uint64_t step;
+    uint64_t count;
+    uint64_t reserved;
+};
+
+struct ShmHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerBytes;
+    std::atomic<uint64_t> segmentBytes; // Grows when capacity does; readers remap
+    std::atomic<uint64_t> capacity;     // Entries per array
+    std::atomic<uint32_t> front;        // Slot holding the latest complete step
+    uint32_t speciesCount;
+    uint64_t namesOffset;
+    uint64_t slotsOffset;
+    ShmSlot slot[2];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory seqlock needs lock-free 64-bit atomics");
+
+inline size_t shmAlign(size_t n) {
+    return (n + SHM_ALIGN - 1) / SHM_ALIGN * SHM_ALIGN;
+}
+
+inline size_t shmElementBytes(uint32_t array) {
+    return array == SHM_SPECIES ? sizeof(uint16_t) : array == SHM_ID ? sizeof(uint32_t) : sizeof(float);
+}
+
+// Offset of one array from the start of its slot
+inline size_t shmArrayOffset(uint32_t array, size_t capacity) {
+    size_t offset = 0;
+    for (uint32_t a = 0; a < array; ++a) offset += shmAlign(shmElementBytes(a) * capacity);
+    return offset;
+}
+
+inline size_t shmSlotBytes(size_t capacity) {
+    return shmArrayOffset(SHM_ARRAYS, capacity);
+}
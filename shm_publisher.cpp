@@ -0,0 +1,176 @@
+#include "shm_publisher.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include "parallel.h"
+#include "simulation.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PARTICLE_SIM_SHM 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Writer side of the seqlock: odd while the slot is being changed
+static void beginWrite(ShmSlot& slot) {
+    uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    if (seq % 2 == 0) slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+static void endWrite(ShmSlot& slot) {
+    slot.seq.store(slot.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+ShmPublisher::~ShmPublisher() {
+    close();
+}
+
+char* ShmPublisher::slot(uint32_t s) const {
+    return base_ + header_->slotsOffset + s * shmSlotBytes(header_->capacity.load(std::memory_order_relaxed));
+}
+
+#ifdef PARTICLE_SIM_SHM
+
+bool ShmPublisher::open(const std::string& name, size_t capacity) {
+    close();
+    shm_unlink(name.c_str());
+    fd_ = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd_ < 0) {
+        std::cerr << "shm_open " << name << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    name_ = name;
+
+    size_t species = speciesCount();
+    size_t namesOffset = shmAlign(sizeof(ShmHeader));
+    size_t slotsOffset = shmAlign(namesOffset + species * SHM_NAME_BYTES);
+    capacity = std::max<size_t>(capacity, 1);
+    if (!map(slotsOffset + 2 * shmSlotBytes(capacity))) {
+        close();
+        return false;
+    }
+
+    // A fresh segment is zero-filled, so both slots start even and empty
+    ShmHeader* h = reinterpret_cast<ShmHeader*>(base_);
+    std::memcpy(h->magic, SHM_MAGIC, sizeof(SHM_MAGIC));
+    h->version = SHM_VERSION;
+    h->headerBytes = sizeof(ShmHeader);
+    h->speciesCount = static_cast<uint32_t>(species);
+    h->namesOffset = namesOffset;
+    h->slotsOffset = slotsOffset;
+    h->capacity.store(capacity, std::memory_order_relaxed);
+    h->front.store(0, std::memory_order_relaxed);
+    for (size_t s = 0; s < species; ++s) {
+        const std::string& n = speciesName(static_cast<uint16_t>(s));
+        std::memcpy(base_ + namesOffset + s * SHM_NAME_BYTES, n.c_str(), std::min(n.size(), SHM_NAME_BYTES - 1));
+    }
+    h->segmentBytes.store(bytes_, std::memory_order_release);
+    header_ = h;
+    return true;
+}
+
+void ShmPublisher::close() {
+    if (base_) munmap(base_, bytes_);
+    if (fd_ >= 0) {
+        ::close(fd_);
+        shm_unlink(name_.c_str());
+    }
+    base_ = nullptr;
+    header_ = nullptr;
+    bytes_ = 0;
+    fd_ = -1;
+}
+
+bool ShmPublisher::map(size_t bytes) {
+    if (ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+        std::cerr << "ftruncate " << name_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    if (base_) munmap(base_, bytes_);
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+        std::cerr << "mmap " << name_ << ": " << std::strerror(errno) << "\n";
+        base_ = nullptr;
+        header_ = nullptr;
+        return false;
+    }
+    base_ = static_cast<char*>(p);
+    header_ = reinterpret_cast<ShmHeader*>(base_);
+    bytes_ = bytes;
+    return true;
+}
+
+#else
+
+bool ShmPublisher::open(const std::string&, size_t) {
+    std::cerr << "Shared-memory publishing needs a POSIX system\n";
+    return false;
+}
+
+void ShmPublisher::close() {}
+
+bool ShmPublisher::map(size_t) {
+    return false;
+}
+
+#endif
+
+bool ShmPublisher::reserve(size_t count) {
+    size_t capacity = header_->capacity.load(std::memory_order_relaxed);
+    if (count <= capacity) return true;
+
+    // Invalidate both slots before the layout changes under the readers
+    beginWrite(header_->slot[0]);
+    beginWrite(header_->slot[1]);
+    capacity = std::max(count, 2 * capacity);
+    size_t slotsOffset = header_->slotsOffset;
+    if (!map(slotsOffset + 2 * shmSlotBytes(capacity))) {
+        close();
+        return false;
+    }
+    header_->capacity.store(capacity, std::memory_order_relaxed);
+    header_->segmentBytes.store(bytes_, std::memory_order_release);
+    return true;
+}
+
+void ShmPublisher::publish(World& w) {
+    if (!header_) return;
+    size_t count = w.particles.size();
+    if (!reserve(count)) return;
+
+    uint32_t back = 1 - header_->front.load(std::memory_order_relaxed);
+    ShmSlot& s = header_->slot[back];
+    beginWrite(s);
+
+    size_t capacity = header_->capacity.load(std::memory_order_relaxed);
+    char* base = slot(back);
+    float* x = reinterpret_cast<float*>(base + shmArrayOffset(SHM_X, capacity));
+    float* y = reinterpret_cast<float*>(base + shmArrayOffset(SHM_Y, capacity));
+    float* vx = reinterpret_cast<float*>(base + shmArrayOffset(SHM_VX, capacity));
+    float* vy = reinterpret_cast<float*>(base + shmArrayOffset(SHM_VY, capacity));
+    float* size = reinterpret_cast<float*>(base + shmArrayOffset(SHM_SIZE, capacity));
+    uint32_t* id = reinterpret_cast<uint32_t*>(base + shmArrayOffset(SHM_ID, capacity));
+    uint16_t* species = reinterpret_cast<uint16_t*>(base + shmArrayOffset(SHM_SPECIES, capacity));
+
+    parallelFor(w.pool, count, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            const Particle& p = w.particles[i];
+            x[i] = p.x;
+            y[i] = p.y;
+            vx[i] = p.vx;
+            vy[i] = p.vy;
+            size[i] = p.size;
+            id[i] = p.id;
+            species[i] = p.species;
+        }
+    });
+    s.step = w.step;
+    s.count = count;
+
+    endWrite(s);
+    header_->front.store(back, std::memory_order_release);
+}
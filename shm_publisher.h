@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "shm_layout.h"
+
+struct World;
+
+// Publishes the particle arrays of every step into a POSIX shared-memory
+// segment (see shm_layout.h) for viewers and analysis tools on the same host.
+class ShmPublisher {
+public:
+    ~ShmPublisher();
+
+    // name is a shm_open name such as "/particle_sim"; an existing segment is replaced
+    bool open(const std::string& name, size_t capacity = 4096);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    // Copies positions, velocities, sizes, ids and species into the back slot and publishes it
+    void publish(World& w);
+
+private:
+    bool map(size_t bytes);
+    bool reserve(size_t count);
+    char* slot(uint32_t s) const;
+
+    std::string name_;
+    int fd_ = -1;
+    char* base_ = nullptr;
+    size_t bytes_ = 0;
+    ShmHeader* header_ = nullptr;
+};
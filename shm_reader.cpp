@@ -0,0 +1,127 @@
+#include "shm_reader.h"
+
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PARTICLE_SIM_SHM 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Attempts before giving up when the writer keeps the front slot busy
+static const int ACQUIRE_RETRIES = 16;
+
+ShmReader::~ShmReader() {
+    close();
+}
+
+#ifdef PARTICLE_SIM_SHM
+
+bool ShmReader::open(const std::string& name) {
+    close();
+    fd_ = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd_ < 0) return false;
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmHeader) || !map(st.st_size)) {
+        close();
+        return false;
+    }
+    if (std::memcmp(header_->magic, SHM_MAGIC, sizeof(SHM_MAGIC)) != 0 || header_->version != SHM_VERSION) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ShmReader::close() {
+    if (base_) munmap(const_cast<char*>(base_), bytes_);
+    if (fd_ >= 0) ::close(fd_);
+    base_ = nullptr;
+    header_ = nullptr;
+    bytes_ = 0;
+    fd_ = -1;
+}
+
+bool ShmReader::map(size_t bytes) {
+    if (base_) munmap(const_cast<char*>(base_), bytes_);
+    void* p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+        base_ = nullptr;
+        header_ = nullptr;
+        return false;
+    }
+    base_ = static_cast<const char*>(p);
+    header_ = reinterpret_cast<const ShmHeader*>(base_);
+    bytes_ = bytes;
+    return true;
+}
+
+#else
+
+bool ShmReader::open(const std::string&) {
+    return false;
+}
+
+void ShmReader::close() {}
+
+bool ShmReader::map(size_t) {
+    return false;
+}
+
+#endif
+
+bool ShmReader::acquire(View& view) {
+    if (!header_) return false;
+
+    for (int attempt = 0; attempt < ACQUIRE_RETRIES; ++attempt) {
+        uint32_t front = header_->front.load(std::memory_order_acquire);
+        const ShmSlot& slot = header_->slot[front];
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq == 0 || seq % 2 != 0) continue;
+
+        size_t capacity = header_->capacity.load(std::memory_order_acquire);
+        size_t segment = header_->segmentBytes.load(std::memory_order_acquire);
+        if (segment > bytes_) {
+            if (!map(segment)) return false;
+            continue;
+        }
+
+        size_t count = slot.count;
+        uint64_t step = slot.step;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq || count > capacity) continue;
+
+        const char* base = base_ + header_->slotsOffset + front * shmSlotBytes(capacity);
+        view.step = step;
+        view.count = count;
+        view.x = reinterpret_cast<const float*>(base + shmArrayOffset(SHM_X, capacity));
+        view.y = reinterpret_cast<const float*>(base + shmArrayOffset(SHM_Y, capacity));
+        view.vx = reinterpret_cast<const float*>(base + shmArrayOffset(SHM_VX, capacity));
+        view.vy = reinterpret_cast<const float*>(base + shmArrayOffset(SHM_VY, capacity));
+        view.size = reinterpret_cast<const float*>(base + shmArrayOffset(SHM_SIZE, capacity));
+        view.id = reinterpret_cast<const uint32_t*>(base + shmArrayOffset(SHM_ID, capacity));
+        view.species = reinterpret_cast<const uint16_t*>(base + shmArrayOffset(SHM_SPECIES, capacity));
+        view.slot = front;
+        view.seq = seq;
+        return true;
+    }
+    return false;
+}
+
+bool ShmReader::validate(const View& view) const {
+    if (!header_) return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header_->slot[view.slot].seq.load(std::memory_order_relaxed) == view.seq;
+}
+
+size_t ShmReader::speciesCount() const {
+    return header_ ? header_->speciesCount : 0;
+}
+
+const char* ShmReader::speciesName(uint16_t species) const {
+    if (!header_ || species >= header_->speciesCount) return "?";
+    return base_ + header_->namesOffset + species * SHM_NAME_BYTES;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "shm_layout.h"
+
+// Reader side of the shared-memory state segment. Only depends on
+// shm_layout.h, so tools can link it without the simulation.
+//
+//     ShmReader reader;
+//     reader.open("/particle_sim");
+//     ShmReader::View v;
+//     if (reader.acquire(v)) {
+//         ... use v.x[i], v.species[i], ... in place ...
+//         if (!reader.validate(v)) { /* overwritten meanwhile, discard */ }
+//     }
+class ShmReader {
+public:
+    // Arrays of one published step, pointing straight into the segment
+    struct View {
+        uint64_t step = 0;
+        size_t count = 0;
+        const float* x = nullptr;
+        const float* y = nullptr;
+        const float* vx = nullptr;
+        const float* vy = nullptr;
+        const float* size = nullptr;
+        const uint32_t* id = nullptr;
+        const uint16_t* species = nullptr;
+
+        uint32_t slot = 0;
+        uint64_t seq = 0;
+    };
+
+    ~ShmReader();
+
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    // Latest complete step; false while nothing is published or the writer
+    // holds both slots. May remap the segment, which invalidates older views.
+    bool acquire(View& view);
+
+    // True when the view's slot has not been rewritten since acquire; call
+    // after using the data and discard the results otherwise
+    bool validate(const View& view) const;
+
+    size_t speciesCount() const;
+    const char* speciesName(uint16_t species) const;
+
+private:
+    bool map(size_t bytes);
+
+    int fd_ = -1;
+    const char* base_ = nullptr;
+    size_t bytes_ = 0;
+    const ShmHeader* header_ = nullptr;
+};
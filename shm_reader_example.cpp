@@ -0,0 +1,49 @@
+// Example external reader: maps the segment published with --shm=<name> and
+// prints a summary of the latest step twice a second.
+//
+//     ./particle_simulation --shm=/particle_sim
+//     ./shm_reader_example /particle_sim [samples]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "shm_reader.h"
+
+int main(int argc, char** argv) {
+    const char* name = argc > 1 ? argv[1] : "/particle_sim";
+    long samples = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 0;
+
+    ShmReader reader;
+    while (!reader.open(name)) {
+        std::printf("Waiting for %s...\n", name);
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    std::vector<uint32_t> population(reader.speciesCount());
+    for (long n = 0; samples == 0 || n < samples; ++n) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        ShmReader::View v;
+        if (!reader.acquire(v)) continue;
+
+        // Work on the arrays in place, then check the writer did not overwrite them meanwhile
+        double speed = 0.0;
+        std::fill(population.begin(), population.end(), 0);
+        for (size_t i = 0; i < v.count; ++i) {
+            speed += std::sqrt(v.vx[i] * v.vx[i] + v.vy[i] * v.vy[i]);
+            if (v.species[i] < population.size()) population[v.species[i]]++;
+        }
+        if (!reader.validate(v)) continue;
+
+        size_t top = std::max_element(population.begin(), population.end()) - population.begin();
+        std::printf("step %llu  particles %zu  mean speed %.3f  most common %s (%u)\n",
+                    static_cast<unsigned long long>(v.step), v.count, v.count ? speed / v.count : 0.0,
+                    population.empty() ? "-" : reader.speciesName(static_cast<uint16_t>(top)),
+                    population.empty() ? 0u : population[top]);
+    }
+    return 0;
+}
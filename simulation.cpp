@@ -0,0 +1,1276 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+#include "event_log.h"
+#include "parallel.h"
+
+const SpeciesList ELEMENT_TYPES = {
+     {"H", 10.0f}, {"He", 11.0f}, {"Li", 12.0f}, {"Be", 13.0f}, {"B", 14.0f},
+    {"C", 15.0f}, {"N", 16.0f}, {"O", 17.0f}, {"F", 18.0f}, {"Ne", 19.0f},
+    {"Na", 20.0f}, {"Mg", 21.0f}, {"Al", 22.0f}, {"Si", 23.0f}, {"P", 24.0f},
+    {"S", 25.0f}, {"Cl", 26.0f}, {"Ar", 27.0f}, {"K", 28.0f}, {"Ca", 29.0f},
+    {"Sc", 30.0f}, {"Ti", 31.0f}, {"V", 32.0f}, {"Cr", 33.0f}, {"Mn", 34.0f},
+    {"Fe", 35.0f}, {"Co", 36.0f}, {"Ni", 37.0f}, {"Cu", 38.0f}, {"Zn", 39.0f},
+    {"Ga", 40.0f}, {"Ge", 41.0f}, {"As", 42.0f}, {"Se", 43.0f}, {"Br", 44.0f},
+    {"Kr", 45.0f}, {"Rb", 46.0f}, {"Sr", 47.0f}, {"Y", 48.0f}, {"Zr", 49.0f},
+    {"Nb", 50.0f}, {"Mo", 51.0f}, {"Tc", 52.0f}, {"Ru", 53.0f}, {"Rh", 54.0f},
+    {"Pd", 55.0f}, {"Ag", 56.0f}, {"Cd", 57.0f}, {"In", 58.0f}, {"Sn", 59.0f},
+    {"Sb", 60.0f}, {"Te", 61.0f}, {"I", 62.0f}, {"Xe", 63.0f}, {"Cs", 64.0f},
+    {"Ba", 65.0f}, {"La", 66.0f}, {"Ce", 67.0f}, {"Pr", 68.0f}, {"Nd", 69.0f},
+    {"Pm", 70.0f}, {"Sm", 71.0f}, {"Eu", 72.0f}, {"Gd", 73.0f}, {"Tb", 74.0f},
+    {"Dy", 75.0f}, {"Ho", 76.0f}, {"Er", 77.0f}, {"Tm", 78.0f}, {"Yb", 79.0f},
+    {"Lu", 80.0f}, {"Hf", 81.0f}, {"Ta", 82.0f}, {"W", 83.0f}, {"Re", 84.0f},
+    {"Os", 85.0f}, {"Ir", 86.0f}, {"Pt", 87.0f}, {"Au", 88.0f}, {"Hg", 89.0f},
+    {"Tl", 90.0f}, {"Pb", 91.0f}, {"Bi", 92.0f}, {"Po", 93.0f}, {"At", 94.0f},
+    {"Rn", 95.0f}, {"Fr", 96.0f}, {"Ra", 97.0f}, {"Ac", 98.0f}, {"Th", 99.0f},
+    {"Pa", 100.0f}, {"U", 101.0f}, {"Np", 102.0f}, {"Pu", 103.0f}, {"Am", 104.0f},
+    {"Cm", 105.0f}, {"Bk", 106.0f}, {"Cf", 107.0f}, {"Es", 108.0f}, {"Fm", 109.0f},
+    {"Md", 110.0f}, {"No", 111.0f}, {"Lr", 112.0f}, {"Rf", 113.0f}, {"Db", 114.0f},
+    {"Sg", 115.0f}, {"Bh", 116.0f}, {"Hs", 117.0f}, {"Mt", 118.0f}, {"Ds", 119.0f},
+    {"Rg", 120.0f}, {"Cn", 121.0f}, {"Nh", 122.0f}, {"Fl", 123.0f}, {"Mc", 124.0f},
+    {"Lv", 125.0f}, {"Ts", 126.0f}, {"Og", 127.0f}
+};
+const SpeciesList FUNDAMENTAL_PARTICLES = {
+    {"Up quark", 10.0f},
+    {"Down quark", 10.0f},
+    {"Charm quark", 10.0f},
+    {"Strange quark", 10.0f},
+    {"Top quark", 10.0f},
+    {"Bottom quark", 10.0f},
+
+    // Leptons
+    {"Electron", 10.0f},
+    {"Muon", 10.0f},
+    {"Tau", 10.0f},
+    {"Electron neutrino", 10.0f},
+    {"Muon neutrino", 10.0f},
+    {"Tau neutrino", 10.0f},
+
+    // Gauge Bosons
+    {"Photon", 10.0f},
+    {"Gluon", 10.0f},
+    {"W boson", 10.0f},
+    {"Z boson", 10.0f},
+    {"Graviton", 10.0f},
+
+    // Higgs Boson
+    {"Higgs boson", 10.0f},
+
+    // Baryons
+    {"Proton", 10.0f},
+    {"Neutron", 10.0f},
+
+    // Antiparticles (mass = particle's mass)
+    {"Positron (anti-electron)", 10.0f},
+    {"Electron antineutrino", 10.0f},
+    {"Antiproton", 10.0f},
+    {"Antineutron", 10.0f}
+};
+
+using ReactionTable = std::unordered_map<std::string, std::unordered_map<std::string, std::string>>;
+
+// Built once on first use; duplicate keys keep their first entry
+static const ReactionTable& reactionTable() {
+    static const ReactionTable reactions = {
+        {"Li", {{"Al", "LiAl"}, {"Br", "LiBr"}, {"Cl", "LiCl"}, {"F", "LiF"}, {"H", "LiH"},
+                {"I", "LiI"}, {"Mg", "LiMg"}, {"Li", "Li2"}}},
+        {"Be", {{"O", "BeO"}, {"S", "BeS"}, {"Se", "BeSe"}, {"Te", "BeTe"}, {"O2", "BeO2"}}},
+        {"B", {{"N", "BN"}, {"P", "BP"}, {"As", "BAs"}, {"S", "BS"}, {"Si", "BSi"}, {"Fe", "FeB"},
+               {"Ni", "NiB"}, {"Co", "CoB"}}},
+        {"C", {{"N", "CN"}, {"C", "C2"}, {"Si", "SiC"}, {"Ti", "TiC"}, {"Zr", "ZrC"}, {"Nb", "NbC"},
+               {"W", "WC"}, {"V", "VC"}}},
+        {"N", {{"N", "N2"}, {"Si", "SiC"}, {"Ti", "TiC"}, {"Zr", "ZrC"}, {"Nb", "NbC"}, {"W", "WC"},
+               {"V", "VC"}, {"Al", "AlN"}, {"Cr", "CrN"}, {"Ga", "GaN"}, {"In", "InN"}, {"Sc", "ScN"},
+               {"Y", "YN"}}},
+        {"H2", {{"O2", "H2O"}, {"Ba", "BaH2"}, {"Be", "BeH2"}, {"Fe", "FeH2"}, {"Ca", "CaH2"},
+                {"Mg", "MgH2"}, {"S", "H2S"}, {"Se", "H2Se"}, {"Te", "H2Te"}, {"Zn", "ZnH2"}}},
+        {"O2", {{"C", "CO2"}, {"S", "SO2"}, {"Se", "SeO2"}, {"Te", "TeO2"}, {"Si", "SiO2"}, {"Ti", "TiO2"},
+        {"V", "VO2"}, {"Mn", "MnO2"}, {"O", "O3"}}},
+        {"N2", {{"O2", "NO"}, {"O2", "NO2"}, {"O2", "N2O"}}},
+        {"Ba", {{"H2", "BaH2"}}},
+        {"Ca", {{"H2", "CaH2"}}}
+,{"Fe", {{"Fe", "Fe2"}, {"H2", "FeH2"},
+{"F2", "FeF2"},
+{"Cl2", "FeCl2"},
+{"Br2", "FeBr2"},
+{"I2", "FeI2"},
+{"N", "FeN"},
+{"B", "FeB"},
+{"Al", "FeAl"},
+{"Cu", "CuFe"}}},
+{"Fe2", {{"Zn", "ZnFe2"},
+{"Ni", "NiFe2"}}},
+{"Mg", {{"H2", "MgH2"},
+{"O", "MgO"},
+{"F2", "MgF2"},
+{"Cl2", "MgCl2"},
+{"Br2", "MgBr2"},
+{"I2", "MgI2"},
+{"B2", "MgB2"},
+{"Al2", "MgAl2"},
+{"Cu", "CuMg"},
+    {"Mg", "Mg2"},
+{"Na", "NaMg"},
+{"K", "KMg"},
+{"Rb", "RbMg"},
+{"Cs", "CsMg"}}},
+{"Mg2", {{"Zn", "ZnMg2"},
+{"Ni", "NiMg2"}}},
+        {"O", {{"H2", "H2O"}, {"O", "O2"}, {"F2", "OF2"}, {"Cl2", "OCl2"}, {"Br2", "OBr2"}, {"O", "OI2"},
+        {"C", "CO"}, {"Mg", "MgO"}, {"Ca", "CaO"}, {"Se", "SeO2"}, {"Fe", "FeO"}, {"Cu", "CuO"}, {"Zn", "ZnO"},
+        {"Ni", "NiO"}, {"Mn", "MnO"}}},
+{"S", {{"S", "S2"}, {"H2", "H2S"},
+{"O2", "SO2"},
+{"F2", "SF2"},
+{"Cl2", "SCl2"},
+{"Br2", "SBr2"},
+{"I2", "SI2"},
+{"N", "NS"},
+{"B", "BS"},
+{"Cu", "CuS"},
+{"Zn", "ZnS"},
+{"Ni", "NiS"},
+{"Na2", "Na2S"},
+{"K2", "K2S"},
+{"Rb2", "Rb2S"},
+{"Cs2", "Cs2S"},
+{"Li2", "Li2S"},
+{"Mg", "MgS"},
+{"Ca", "CaS"},
+{"Sr", "SrS"},
+{"Ba", "BaS"}}},
+        {"S2", {{"C", "CS2"}}},
+{"Se", {{"H2", "H2Se"},
+{"O2", "SeO2"},
+{"F2", "SeF2"},
+{"Cl2", "SeCl2"},
+{"Br2", "SeBr2"},
+{"I2", "SeI2"},
+{"N2", "SeN2"},
+{"Se", "Se2"},
+{"B", "BSe"},
+{"Cu", "CuSe"},
+{"Zn", "ZnSe"},
+{"Ni", "NiSe"},
+{"Na2", "Na2Se"},
+{"K2", "K2Se"},
+{"Rb2", "Rb2Se"},
+{"Cs2", "Cs2Se"},
+{"Li2", "Li2Se"},
+{"Mg", "MgSe"},
+{"Ca", "CaSe"},
+{"Sr", "SrSe"},
+{"Ba", "BaSe"}}},
+        {"Se2", {{"C", "CSe2"}}},
+{"Te", {{"Te", "Te2"}, {"H2", "H2Te"},
+{"O2", "TeO2"},
+{"N2", "TeN2"},
+{"B", "BTe"},
+{"Cu", "CuTe"},
+{"Zn", "ZnTe"},
+{"Ni", "NiTe"},
+{"Na2", "Na2Te"},
+{"K2", "K2Te"},
+{"Rb2", "Rb2Te"},
+{"Cs", "Cs2Te"},
+{"Li2", "Li2Te"},
+{"Mg", "MgTe"},
+{"Ca", "CaTe"},
+{"Sr", "SrTe"},
+{"Ba", "BaTe"}}},
+        {"Te2", {{"C", "CTe2"}}},
+{"Zn", {{"H", "ZnH2"},
+{"O", "ZnO"},
+{"F2", "ZnF2"},
+{"Cl2", "ZnCl2"},
+{"Br2", "ZnBr2"},
+{"I2", "ZnI2"},
+{"B2", "ZnB2"},
+{"Al2", "ZnAl2"},
+{"Cu", "CuZn"},
+{"Ni", "NiZn"},
+{"Na", "Na2Zn"},
+{"K2", "K2Zn"},
+{"Rb2", "Rb2Zn"},
+{"Cs2", "Cs2Zn"},
+{"Li", "LiZn"},
+{"Mg", "MgZn"},
+{"Ca", "CaZn"}}},
+{"Na", {{"Na", "Na2"}, {"H", "NaH"},
+{"F", "NaF"},
+{"Cl", "NaCl"},
+{"Br", "NaBr"},
+{"I", "NaI"},
+{"B", "NaB"},
+{"Al", "NaAl"},
+{"Cu", "CuNa"},
+{"K", "NaK"},
+{"Rb", "NaRb"},
+{"Cs", "NaCs"},
+{"Li", "NaLi"}}},
+{"Na2", {{"O", "Na2O"}, {"Zn", "ZnNa2"},
+{"Ni", "NiNa2"},{"He", "Na2He"}, {"O", "Na2O"}}},
+        {"F", {{"F", "F2"}, {"H", "HF"}, {"Cl", "FCl"}, {"Br", "FBr"}, {"I", "FI"}, {"Cu", "CuF"},
+        {"Na", "NaF"}, {"K", "KF"}, {"Li", "LiF"}, {"Rb", "RbF"}, {"Cs", "CsF"}}},
+        {"F2", {{"O", "OF2"}, {"Zn", "ZnF2"}, {"Ni", "NiF2"}, {"Mn", "MnF2"}}},
+        {"Cl", {{"Cl", "Cl2"}, {"H", "HCl"}, {"O2", "ClO2"}, {"F", "ClF"}, {"Br", "ClBr"}, {"I", "Cl"},
+        {"Cu", "CuCl"}, {"Na", "NaCl"}, {"K", "KCl"}, {"Li", "LiCl"}, {"Rb", "RbCl"}, {"Cs", "CsCl"}}},
+        {"Cl2", {{"O", "OCl2"}, {"S", "Cl2S"}, {"Se", "Cl2Se"}, {"Te", "Cl2Te"}, {"Cl", "Cl2"},
+        {"Zn", "ZnCl2"}, {"Ni", "NiCl2"}, {"Mn", "MnCl2"}}},
+{"Br", {{"Br", "Br2"}, {"Br", "Br2"}, {"H", "HBr"},
+{"F", "BrF"},
+{"Cl", "ClBr"},
+{"I", "BrI"},
+{"N", "BrNO"},
+{"Cu", "CuBr"},
+{"Na", "NaBr"},
+{"K", "KBr"},
+{"Li", "LiBr"},
+{"Rb", "RbBr"},
+{"Cs", "CsBr"}}},
+        {"Br2", {{"O", "OBr2"}, {"Zn", "ZnBr2"},
+{"Ni", "NiBr2"}}},
+{"I", {{"H", "HI"},
+{"F", "IF"},
+{"Cl", "ClI"},
+{"Br", "BrI"},
+{"Cu", "CuI"},
+{"Na", "NaI"},
+{"K", "KI"},
+{"Li", "LiI"},
+{"Rb", "RbI"},
+{"Cs", "CsI"}}},
+        {"I2", {{"O", "OI2"}, {"Zn", "ZnI2"},
+{"Ni", "NiI2"},
+}},
+{"Li2", {{"O", "Li2O"},  {"Zn", "ZnLi2"},
+{"Ni", "NiLi2"}}},
+{"K", { {"H", "KH"},
+{"F", "KF"},
+{"Cl", "KCl"},
+{"Br", "KBr"},
+{"I", "KI"},
+{"B", "KB"},
+{"Al", "KAl"},
+{"Cu", "CuK"},
+{"Na", "NaK"},
+{"Li", "LiK"},
+{"Rb", "RbK"},
+{"Cs", "CsK"}}},
+        {"K2", {{"O", "K2O"}, {"Zn", "ZnK2"},
+{"Ni", "NiK2"},
+}},
+{"Rb", {{"H", "RbH"},
+{"F", "RbF"},
+{"Cl", "RbCl"},
+{"Br", "RbBr"},
+{"I", "RbI"},
+{"B", "RbB"},
+{"Al", "RbAl"},
+{"Cu", "CuRb"},
+{"Na", "NaRb"},
+{"Li", "LiRb"},
+{"K", "KRb"},
+{"Cs", "CsRb"}}},
+{"Rb2", {{"O", "Rb2O"}, {"Zn", "ZnRb2"},
+{"Ni", "NiRb2"},}},
+{"Cs", {{"H", "CsH"},
+{"F", "CsF"},
+{"Cl", "CsCl"},
+{"Br", "CsBr"},
+{"I", "CsI"},
+{"B", "CsB"},
+{"Al", "CsAl"},
+{"Cu", "CuCs"},
+{"Na", "NaCs"},
+{"Li", "LiCs"},
+{"K", "KCs"},
+{"Rb", "RbCs"}}},
+        {"Cs2", {{"O", "Cs2O"}, {"Zn", "ZnCs2"},
+{"Ni", "NiCs2"}
+        }},
+        {"P", {
+    {"N", "PN"},
+    {"B", "PB"},
+    {"Al", "PAl"},
+    {"Cu", "CuP"},
+    {"Zn", "ZnP"},
+    {"Ni", "NiP"},
+    {"Na", "NaP"},
+    {"K", "KP"},
+    {"Rb", "RbP"},
+    {"Cs", "CsP"}}},
+    {"S", {{"H2", "H2S"},
+    {"O2", "SO2"},
+    {"Cl2", "SCl2"},
+    {"Br2", "SBr2"},
+    {"I2", "SI2"},
+    {"N2", "SN2"},
+    {"B", "SB"},
+    {"Al2", "SAl2"},
+    {"Cu", "CuS"},
+    {"Zn", "ZnS"},
+    {"Ni", "NiS"},
+    {"Na2", "Na2S"},
+    {"K2", "K2S"},
+    {"Rb2", "Rb2S"},
+    {"Cs2", "Cs2S"}}},
+    {"Sr", {{"H2", "SrH2"},
+        {"O", "SrO"},
+        {"F2", "SrF2"},
+        {"Cl2", "SrCl2"},
+        {"Br2", "SrBr2"},
+        {"I2", "SrI2"},
+        {"B", "SrB"},
+        {"Al2", "SrAl2"},
+        {"Cu", "CuSr"},
+        {"Na", "NaSr"},
+        {"K", "KSr"},
+        {"Rb", "RbSr"},
+        {"Cs", "CsSr"},
+    }},
+    {"Sr2", {{"Zn", "ZnSr2"},
+    {"Ni", "NiSr2"}}},
+    {"Sr", {{"Sr", "Sr2"}}},
+    {"Ra", {{"H", "RaH2"},
+    {"O", "RaO"},
+    {"F2", "RaF2"},
+    {"Cl2", "RaCl2"},
+    {"Br2", "RaBr2"},
+    {"I2", "RaI2"},
+    {"B", "RaB"},
+    {"Al2", "RaAl2"},
+    {"Cu", "CuRa"},
+    {"Na", "NaRa"},
+    {"K", "KRa"},
+    {"Rb", "RbRa"},
+    {"Cs", "CsRa"}}},
+    {"Ra2", {{"Ra", "Ra2"},{"Zn", "ZnRa2"},
+    {"Ni", "NiRa2"}}},
+    {"Fr", {{"H", "FrH"},
+    {"F", "FrF"},
+    {"Cl", "FrCl"},
+    {"Br", "FrBr"},
+    {"I", "FrI"},
+    {"B", "FrB"},
+    {"Al", "FrAl"},
+    {"Cu", "CuFr"},
+    {"Na", "NaFr"},
+    {"Li", "LiFr"},
+    {"K", "KFr"},
+    {"Rb", "RbFr"},
+    {"Cs", "CsFr"}}},
+    {"Fr", {{"Fr", "Fr2"}, {"O", "Fr2O"},
+    {"Zn", "ZnFr2"},
+    {"Ni", "NiFr2"}}},
+    {"Sc", {{"H2", "ScH2"},
+        {"N", "ScN"},
+        {"B", "ScB"},
+        {"Al", "ScAl"},
+        {"Cu", "CuSc"}}},
+    {"Sc2", {{"Sc", "Sc2"}, {"Zn", "ZnSc2"},
+        {"Ni", "NiSc2"}}},
+    {"Ra", {
+        {"N", "YN"},
+        {"B", "YB"},
+        {"Al2", "YAl2"}}},
+    {"Y", {{"Y", "Y2"},     {"Zn", "ZnY2"},
+        {"Ni", "NiY2"}}},
+    {"Ti", { {"H2", "TiH2"},
+        {"O2", "TiO2"},
+        {"N", "TiN"},
+        {"B2", "TiB2"},
+        {"Cu", "CuTi"},
+        {"Zn", "ZnTi"},
+        {"Ni", "NiTi"}}},
+    {"V", {{"V", "V2"}, {"H2", "VH2"},
+    {"N", "VN"},
+    {"B2", "VB2"},
+    {"Cu", "CuV"}}},
+    {"V", {{"Zn", "ZnV2"},
+    {"Ni", "NiV2"}}},
+    {"Cr", {{"Cr", "Cr2"}, {"H2", "CrH2"},
+        {"N", "CrN"},
+        {"B", "CrB"},
+        {"Al", "CrAl"},
+        {"Cu", "CuCr"}}},
+    {"Cr2", {{"Zn", "ZnCr2"},
+    {"Ni", "NiCr2"}}},
+    {"Mn", {{"Mn", "Mn2"}, {"H2", "MnH2"},
+    {"O2", "MnO2"},
+    {"Cl2", "MnCl2"},
+    {"Br2", "MnBr2"},
+    {"I2", "MnI2"},
+    {"N", "MnN"},
+    {"B", "MnB"},
+    {"Al", "MnAl"},
+    {"Cu", "CuMn"}}},
+    {"Mn2", {{"Zn", "ZnMn2"},
+    {"Ni", "NiMn2"}}},
+    {"Co", { {"Co", "Co2"}, {"H2", "CoH2"},
+        {"O", "CoO"},
+        {"F2", "CoF2"},
+        {"Cl2", "CoCl2"},
+        {"Br2", "CoBr2"},
+        {"I2", "CoI2"},
+        {"N", "CoN"},
+        {"B", "CoB"},
+        {"Al", "CoAl"},
+        {"Cu", "CuCo"},
+        {"Na", "NaCo"},
+        {"K", "KCo"},
+        {"Rb", "RbCo"},
+        {"Cs", "CsCo"}}},
+    {"Co2", {    {"Zn", "ZnCo2"},
+    {"Ni", "NiCo2"}}},
+    {"Cu", {{"H2", "CuH2"},
+    {"O", "CuO"},
+    {"F2", "CuF2"},
+    {"Cl2", "CuCl2"},
+    {"Br2", "CuBr2"},
+    {"I2", "CuI2"},
+    {"N", "CuN"},
+    {"B", "CuB"},
+    {"Al", "CuAl"},
+    {"Zn", "CuZn"},
+    {"Ni", "CuNi"},
+    {"Na", "NaCu"},
+    {"K", "KCu"},
+    {"Rb", "RbCu"},
+    {"Cs", "CsCu"}}},
+    {"Zr", {{"H2", "ZrH2"},
+    {"O2", "ZrO2"},
+    {"N", "ZrN"}, {"Zr", "Zr2"},
+    {"B2", "ZrB2"},
+    {"Cu", "CuZr"}}},
+    {"Zr2", {{"Zn", "ZnZr2"},
+    {"Ni", "NiZr2"}}},
+    {"Nb", {{"H2", "NbH2"},
+    {"N", "NbN"},
+    {"B2", "NbB2"},
+    {"Cu", "CuNb"},
+        {"Nb", "Nb2"}}},
+    {"Nb2", {{"Zn", "ZnNb2"},
+    {"Ni", "NiNb2"}}},
+    {"Mo", {{"H2", "MoH2"},
+    {"N", "MoN"},
+    {"B2", "MoB2"},
+    {"Cu", "CuMo"}}},
+    {"Mo2", {{"Zn", "ZnMo2"},
+    {"Ni", "NiMo2"}}},
+    {"Tc", {{"H", "TcH2"},
+    {"O2", "TcO2"},
+    {"N", "TcN"},
+    {"B", "TcB"},
+    {"Cu", "CuTc"}, {"Tc", "Tc2"}}},
+    {"Tc2", {{"Zn", "ZnTc2"},
+    {"Ni", "NiTc2"}}},
+    {"Ru", {{"H2", "RuH2"},
+    {"O2", "RuO2"},
+    {"N", "RuN"},
+    {"B", "RuB"},
+    {"Cu", "CuRu"},
+    {"Ru", "Ru2"}}},
+    {"Ru2", {{"Zn", "ZnRu2"},
+    {"Ni", "NiRu2"}}},
+    {"Rh", {{"H2", "RhH2"},
+    {"N", "RhN"},
+    {"B", "RhB"},
+    {"Cu", "CuRh"},
+    {"Rh", "Rh2"}}},
+    {"Rh2", {
+        {"Zn", "ZnRh2"},
+        {"Ni", "NiRh2"}}},
+    {"Pd", {{"H2", "PdH2"},
+    {"O", "PdO"},
+    {"F2", "PdF2"},
+    {"Cl2", "PdCl2"},
+    {"Br2", "PdBr2"},
+    {"I2", "PdI2"},
+    {"N", "PdN"},
+    {"B", "PdB"},
+    {"Cu", "CuPd"}, {"Pd", "Pd2"}}},
+    {"Pd2", {{"Zn", "ZnPd2"},
+    {"Ni", "NiPd2"}}},
+    {"Pt", {{"H2", "PtH2"},
+    {"O2", "PtO2"},
+    {"N", "PtN"},
+    {"B", "PtB"},
+    {"Cu", "CuPt"},{"Pt", "Pt2"}}},
+    {"Pt2", {{"Zn", "ZnPt2"},
+    {"Ni", "NiPt2"}}},
+    {"Au", {{"N", "AuN"},
+    {"B", "AuB"},
+    {"Cu", "CuAu"}, {"Au", "Au2"}}},
+    {"Au2", {{"Zn", "ZnAu2"},
+    {"Ni", "NiAu2"}}},
+    {"Hg", {{"H2", "HgH2"},
+    {"O", "HgO"},
+    {"F2", "HgF2"},
+    {"Cl2", "HgCl2"},
+    {"Br2", "HgBr2"},
+    {"I2", "HgI2"},
+    {"N", "HgN"},
+    {"B2", "HgB2"},
+    {"Al2", "HgAl2"},
+    {"Cu", "CuHg"},
+    {"Hg", "Hg2"}}},
+    {"Hg2", {{"Zn", "ZnHg2"},
+    {"Ni", "NiHg2"}}},
+    {"Tl", {{"H", "TlH"},
+    {"N", "TlN"},
+    {"B", "TlB"},
+    {"Cu", "CuTl"},
+    {"Tl", "Tl2"}}},
+    {"Tl2", {{"Zn", "ZnTl2"},
+    {"Ni", "NiTl2"}}},
+    {"Pb", {{"H2", "PbH2"},
+    {"O", "PbO"},
+    {"F2", "PbF2"},
+    {"Cl2", "PbCl2"},
+    {"Br2", "PbBr2"},
+    {"I2", "PbI2"},
+    {"N", "PbN"},
+    {"B2", "PbB2"},
+    {"Cu", "CuPb"}, {"Pb", "Pb2"}}},
+    {"Pb2", {{"Zn", "ZnPb2"},
+    {"Ni", "NiPb2"}}},
+    {"Bi", {
+    {"N", "BiN"},
+    {"B", "BiB"},
+    {"Cu", "CuBi"}, {"Bi", "Bi2"}}},
+    {"Bi2", {{"Zn", "ZnBi2"},
+    {"Ni", "NiBi2"}}},
+    {"Po", {{"H2", "PoH2"},
+    {"O2", "PoO2"},
+    {"F2", "PoF2"},
+    {"Cl2", "PoCl2"},
+    {"Br2", "PoBr2"},
+    {"I2", "PoI2"},
+    {"N", "PoN"},
+    {"B", "PoB"},
+    {"Cu", "CuPo"}, {"Po", "Po2"}}},
+    {"Po2", {{"Zn", "ZnPo2"},
+    {"Ni", "NiPo2"}}},
+    {"At", {{"H", "AtH"}, {"At", "At2"},
+    {"N", "AtN"},
+    {"B", "AtB"},
+    {"Cu", "CuAt"}}},
+    {"At2", {{"O", "At2O"}, {"Zn", "ZnAt2"},
+    {"Ni", "NiAt2"}}},
+    {"At", {
+            {"H", "HAt"},
+            {"Li", "LiAt"},
+            {"Na", "NaAt"},
+            {"K", "KAt"},
+            {"Rb", "RbAt"},
+            {"Cs", "CsAt"},
+            {"Fr", "FrAt"},
+            {"Mg", "MgAt2"},
+            {"Ca", "CaAt2"},
+            {"Sr", "SrAt2"},
+            {"Ba", "BaAt2"},
+            {"Ra", "RaAt2"},
+            {"Tl", "TlAt"},
+            {"Pb", "PbAt2"},
+            {"O", "OAt2"},
+            {"S", "SAt2"},
+            {"Se", "SeAt2"},
+            {"Te", "TeAt2"},
+            {"F", "FAt"},
+            {"Cl", "ClAt"},
+            {"Br", "BrAt"},
+            {"I", "IAt"},
+            {"At", "At2"}}},
+    {"Rf", {
+            {"O", "RfO2"}}},
+    {"Db", {
+        {"O", "DbO2"}}},
+    {"Mt", {
+            {"O", "MtO2"}
+    }},
+    {"Ds", {
+            {"O", "DsO2"}
+    }},
+    {"Rg", {
+            {"O", "RgO"}
+    }},
+    {"Cn", {
+            {"F", "CnF2"},
+            {"Cl", "CnCl2"},
+            {"Br", "CnBr2"},
+            {"I", "CnI2"},
+            {"O", "CnO"}
+    }},
+    {"Nh", {
+            {"O", "NhO"}
+    }},
+    {"Fl", {
+            {"O", "FlO2"}
+    }},
+    {"Mc", {
+            {"I", "McI3"},
+            {"O", "McO"}
+    }},
+    {"Lv", {
+            {"F", "LvF2"},
+            {"Cl", "LvCl2"},
+            {"Br", "LvBr2"},
+            {"I", "LvI2"},
+            {"O", "LvO2"}
+    }},
+    {"Og", {
+            {"F", "OgF2"},
+            {"Cl", "OgCl2"},
+            {"Br", "OgBr2"},
+            {"I", "OgI2"},
+            {"O", "OgO2"}}}
+
+    };
+    return reactions;
+}
+
+struct SpeciesTable {
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint16_t> ids;
+
+    void add(const std::string& name) {
+        if (ids.count(name)) return;
+        ids[name] = static_cast<uint16_t>(names.size());
+        names.push_back(name);
+    }
+};
+
+// Every name a particle can have: the element and particle lists plus all
+// reaction inputs and products. The set is closed, so the table never changes
+// after it is built and can be read from any thread.
+static const SpeciesTable& speciesTable() {
+    static const SpeciesTable table = [] {
+        SpeciesTable t;
+        for (const auto& [name, size] : ELEMENT_TYPES) t.add(name);
+        for (const auto& [name, size] : FUNDAMENTAL_PARTICLES) t.add(name);
+        std::vector<std::string> extra;
+        for (const auto& [a, products] : reactionTable()) {
+            extra.push_back(a);
+            for (const auto& [b, product] : products) {
+                extra.push_back(b);
+                extra.push_back(product);
+            }
+        }
+        // unordered_map iteration order is unspecified; sort so ids are stable across builds
+        std::sort(extra.begin(), extra.end());
+        for (const auto& name : extra) t.add(name);
+        return t;
+    }();
+    return table;
+}
+
+uint16_t speciesId(const std::string& name) {
+    const auto& ids = speciesTable().ids;
+    auto it = ids.find(name);
+    return it == ids.end() ? UNKNOWN_SPECIES : it->second;
+}
+
+const std::string& speciesName(uint16_t id) {
+    static const std::string unknown = "?";
+    const auto& names = speciesTable().names;
+    return id < names.size() ? names[id] : unknown;
+}
+
+size_t speciesCount() {
+    return speciesTable().names.size();
+}
+
+struct ReactionIndex {
+    size_t words = 0;                // 64-bit words per species row
+    std::vector<uint64_t> bits;      // Bit (a, b) is set when a and b react
+    std::unordered_map<uint32_t, uint16_t> products;  // (a << 16 | b) -> product species
+};
+
+static const ReactionIndex& reactionIndex() {
+    static const ReactionIndex index = [] {
+        ReactionIndex idx;
+        size_t n = speciesCount();
+        idx.words = (n + 63) / 64;
+        idx.bits.assign(n * idx.words, 0);
+        auto add = [&](uint16_t a, uint16_t b, uint16_t product) {
+            // emplace keeps an existing entry, so a -> b wins over the reverse b -> a
+            idx.products.emplace(static_cast<uint32_t>(a) << 16 | b, product);
+            idx.bits[a * idx.words + b / 64] |= uint64_t(1) << (b % 64);
+        };
+        for (const auto& [a, inner] : reactionTable())
+            for (const auto& [b, product] : inner)
+                add(speciesId(a), speciesId(b), speciesId(product));
+        for (const auto& [a, inner] : reactionTable())
+            for (const auto& [b, product] : inner)
+                add(speciesId(b), speciesId(a), speciesId(product));
+        return idx;
+    }();
+    return index;
+}
+
+uint16_t reactionProduct(uint16_t a, uint16_t b) {
+    const ReactionIndex& idx = reactionIndex();
+    if (a == UNKNOWN_SPECIES || b == UNKNOWN_SPECIES) return UNKNOWN_SPECIES;
+    if (!(idx.bits[a * idx.words + b / 64] >> (b % 64) & 1)) return UNKNOWN_SPECIES;
+    return idx.products.at(static_cast<uint32_t>(a) << 16 | b);
+}
+
+std::string reactionOutput(const Particle& a, const Particle& b) {
+    const ReactionTable& reactions = reactionTable();
+
+    // Try finding a reaction from a to b
+    auto it = reactions.find(a.name);
+    if (it != reactions.end()) {
+        auto inner_it = it->second.find(b.name);
+        if (inner_it != it->second.end()) {
+            return inner_it->second;  // found a reaction!
+        }
+    }
+
+    // Try the reverse reaction from b to a
+    it = reactions.find(b.name);
+    if (it != reactions.end()) {
+        auto inner_it = it->second.find(a.name);
+        if (inner_it != it->second.end()) {
+            return inner_it->second;  // found a reaction!
+        }
+    }
+
+    // No reaction found
+    return "";
+}
+
+bool speciesForMode(const std::string& mode, SpeciesList& out) {
+    std::string m = mode;
+    std::transform(m.begin(), m.end(), m.begin(), ::tolower);
+    if (m == "element") out = ELEMENT_TYPES;
+    else if (m == "particle") out = FUNDAMENTAL_PARTICLES;
+    else if (m == "both") {
+        out = ELEMENT_TYPES;
+        out.insert(out.end(), FUNDAMENTAL_PARTICLES.begin(), FUNDAMENTAL_PARTICLES.end());
+    }
+    else return false;
+    return true;
+}
+
+// Minimum separation distance between particles
+float minimumSeparation(const Particle& a, const Particle& b) {
+    return a.size + b.size;
+}
+
+// Helper function to check if a particle overlaps with any others
+bool isOverlapping(const Particle& newParticle, const std::vector<Particle>& particles) {
+    for (const auto& p : particles) {
+        float dx = newParticle.x - p.x;
+        float dy = newParticle.y - p.y;
+        float distanceSquared = dx * dx + dy * dy;
+        float minDist = minimumSeparation(newParticle, p);
+        if (distanceSquared < minDist * minDist) {
+            return true; // Overlap detected
+        }
+    }
+    return false; // No overlap
+}
+
+void generateParticle(World& w, const std::string& particle_name) {
+    std::uniform_real_distribution<float> distX(0.0f, WINDOW_WIDTH);
+    std::uniform_real_distribution<float> distY(0.0f, WINDOW_HEIGHT);
+
+    Particle newParticle;
+
+    // Set properties (you can adjust these!)
+    newParticle.x = 0.0f;
+    newParticle.y = 0.0f;
+    newParticle.size = 10.0f;
+    newParticle.init_vx = 0.0f;
+    newParticle.init_vy = 0.0f;
+    newParticle.vx = 0.0f;
+    newParticle.vy = 0.0f;
+    newParticle.r = 1.0f;
+    newParticle.g = 1.0f;
+    newParticle.b = 1.0f;
+    newParticle.name = particle_name;
+    newParticle.species = speciesId(particle_name);
+    newParticle.id = w.nextId++;
+    newParticle.born_step = w.step;
+    newParticle.merged = false;
+
+    // Try finding a non-overlapping position
+    while (isOverlapping(newParticle, w.particles)) {
+        newParticle.x = distX(w.rng);
+        newParticle.y = distY(w.rng);
+    }
+
+    eventLog.spawn(w.step, newParticle.id, newParticle.size);
+    w.particles.push_back(newParticle);
+}
+
+// Random particle drawn from l, with a random position, velocity and colour
+static Particle makeRandomParticle(World& w, const SpeciesList& l) {
+    std::uniform_int_distribution<> type_dist(0, l.size() - 1);
+    std::uniform_int_distribution<> dist_width(0.0f, static_cast<float>(WINDOW_WIDTH));
+    std::uniform_int_distribution<> dist_height(0.0f, static_cast<float>(WINDOW_HEIGHT));
+    std::uniform_int_distribution<> dist_v(-6.0f, 6.0f);
+    std::uniform_real_distribution<> dist_color(0.0f, 1.0f);
+    std::uniform_int_distribution<> decay_time(1, 11);
+
+    auto& [name, radius] = l[type_dist(w.rng)];
+    Particle p;
+    p.size = radius;
+    p.name = name;
+    p.species = speciesId(name);
+    p.x = dist_width(w.rng);
+    p.y = dist_height(w.rng);
+    p.init_vx = dist_v(w.rng);
+    p.init_vy = dist_v(w.rng);
+    p.vx = p.init_vx;
+    p.vy = p.init_vy;
+    p.r = dist_color(w.rng);
+    p.g = dist_color(w.rng);
+    p.b = dist_color(w.rng);
+    p.id = w.nextId++;
+    p.born_step = w.step;
+    if (p.size >= DECAY_SIZE) {
+        p.decay_time = decay_time(w.rng);
+        p.decay_countdown = p.decay_time * STEPS_PER_SECOND;
+    }
+    eventLog.spawn(w.step, p.id, p.size);
+    return p;
+}
+
+float speciesRadius(uint16_t species, float fallback) {
+    const std::string& name = speciesName(species);
+    for (const SpeciesList* list : {&ELEMENT_TYPES, &FUNDAMENTAL_PARTICLES}) {
+        for (const auto& [listed, radius] : *list) {
+            if (listed == name) return radius;
+        }
+    }
+    return fallback;
+}
+
+void setSpecies(Particle& p, uint16_t species) {
+    p.species = species;
+    p.name = speciesName(species);
+    p.size = speciesRadius(species, p.size);
+    // Re-armed by decayParticle on the next step if the new size is above the threshold
+    p.decay_countdown = 0;
+}
+
+void removeParticles(World& w, const std::vector<uint32_t>& indices) {
+    std::vector<uint32_t> sorted(indices);
+    std::sort(sorted.begin(), sorted.end());
+    size_t out = 0, next = 0;
+    for (size_t i = 0; i < w.particles.size(); ++i) {
+        if (next < sorted.size() && sorted[next] == i) {
+            while (next < sorted.size() && sorted[next] == i) next++;
+            continue;
+        }
+        if (out != i) w.particles[out] = std::move(w.particles[i]);
+        out++;
+    }
+    w.particles.resize(out);
+    w.gridFresh = false;
+    w.edits++;
+}
+
+Particle makeParticle(World& w, uint16_t species, float x, float y, float vx, float vy, float size) {
+    // Reaction products are not listed and default like generateParticle
+    if (size <= 0.0f) size = speciesRadius(species, 10.0f);
+
+    Particle p;
+    p.x = x;
+    p.y = y;
+    p.init_vx = vx;
+    p.init_vy = vy;
+    p.vx = vx;
+    p.vy = vy;
+    p.size = size;
+    p.r = 1.0f;
+    p.g = 1.0f;
+    p.b = 1.0f;
+    p.name = speciesName(species);
+    p.species = species;
+    p.id = w.nextId++;
+    p.born_step = w.step;
+    if (p.size >= DECAY_SIZE) {
+        std::uniform_int_distribution<> decay_time(1, 11);
+        p.decay_time = decay_time(w.rng);
+        p.decay_countdown = p.decay_time * STEPS_PER_SECOND;
+    }
+    eventLog.spawn(w.step, p.id, p.size);
+    return p;
+}
+
+bool decayParticle(Particle& p) {
+    if (p.size < DECAY_SIZE) return false;
+
+    int period = (p.decay_time > 0 ? p.decay_time : DEFAULT_DECAY_SECONDS) * STEPS_PER_SECOND;
+    if (p.decay_countdown <= 0) {
+        // First step above the threshold (e.g. a freshly merged particle)
+        p.decay_countdown = period;
+        return false;
+    }
+    if (--p.decay_countdown > 0) return false;
+
+    p.decay_countdown = period;
+    p.size -= 10.0f;
+    return true;
+}
+
+static void accumulate(ObservablePartial& part, const Particle& p) {
+    part.particles++;
+    part.kineticEnergy += 0.5 * p.size * (p.vx * p.vx + p.vy * p.vy);
+    part.momentumX += p.size * p.vx;
+    part.momentumY += p.size * p.vy;
+    part.trailPoints += p.trail.size();
+    part.asleep += p.asleep;
+    if (p.species < part.population.size()) part.population[p.species]++;
+}
+
+Particle makeProduct(const Particle& a, const Particle& b, uint16_t species, uint32_t id, uint64_t step) {
+    // m1 * vi1 + m2 * vi2 = (m1 + m2) * vf
+    float totalMass = a.size + b.size;
+
+    // New position (center of mass)
+    float newX = (a.x * a.size + b.x * b.size) / totalMass;
+    float newY = (a.y * a.size + b.y * b.size) / totalMass;
+
+    // New velocity (momentum conservation)
+    float newVx = (a.vx * a.size + b.vx * b.size) / totalMass;
+    float newVy = (a.vy * a.size + b.vy * b.size) / totalMass;
+
+    // New size (assuming area is proportional to size^2)
+    float newSize = std::sqrt(a.size * a.size + b.size * b.size);
+
+    // Create the new particle
+    Particle merged;
+    merged.x = newX;
+    merged.y = newY;
+    merged.init_vx = newVx;
+    merged.init_vy = newVy;
+    merged.vx = newVx;
+    merged.vy = newVy;
+    merged.size = newSize;
+    merged.r = (a.r + b.r) / 2.0f;
+    merged.b = (a.b + b.b) / 2.0f;
+    merged.g = (a.g + b.g) / 2.0f;
+    merged.name = speciesName(species);
+    merged.species = species;
+    merged.id = id;
+    merged.born_step = step;
+    merged.parents[0] = a.id;
+    merged.parents[1] = b.id;
+    merged.parent_species[0] = a.species;
+    merged.parent_species[1] = b.species;
+    if (a.name == "H2" || b.name == "H2" || a.name == "O2" || b.name == "O2") {
+        merged.merged = false;
+    }
+    else {
+        merged.merged = true;
+    }
+    merged.trail.push_back({a.x + b.x, a.y + b.y, 2.0f});
+    return merged;
+}
+
+void recordMerge(World& w, const Particle& a, const Particle& b, const Particle& product) {
+    w.merges++;
+    w.heat.deposit(product.x, product.y, w.heat.mergeHeat);
+    eventLog.merge(w.step, a.id, b.id, product.id);
+}
+
+void mergeParticles(World& w, Particle& a, Particle& b, const std::string& new_name) {
+    Particle merged = makeProduct(a, b, speciesId(new_name), w.nextId++, w.step);
+    recordMerge(w, a, b, merged);
+
+    // Queued until the collision pass is done so references into particles stay valid
+    w.spawned.push_back(std::move(merged));
+}
+
+
+void resolveCollision(World& w, Particle& a, Particle& b) {
+    // Compute distance between particles
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float distSq = dx * dx + dy * dy;
+    float minDist = a.size + b.size;
+
+    if (distSq < minDist * minDist) {
+        //m1 * vi1 + m2 * vi2 = (m1 + m2) * vf
+        // && ((abs(a.vx) + abs(b.vx) >= 7.0f && abs(a.vy) + abs(b.vy) >= 7.0f ||(abs(a.init_vx) + abs(b.init_vx) >= 7.0f && abs(a.init_vy) + abs(b.init_vy) >= 7.0f))
+        eventLog.collision(w.step, a.id, b.id);
+        if ((a.merged == false && b.merged == false) && !reactionOutput(a, b).empty()){
+            auto val = reactionOutput(a, b);
+            mergeParticles(w, a, b, val);
+        }
+        else {
+            float r_1 = a.vx - b.vx;
+            float r_2 = a.vy - b.vy;
+            float c_1 = a.x - b.x;
+            float c_2 = a.y - b.y;
+            float r_c = r_1 * c_1 + r_2 * c_2;
+
+            float rb_1 = b.vx - a.vx;
+            float rb_2 = b.vy - a.vy;
+            float cb_1 = b.x - a.x;
+            float cb_2 = b.y - a.y;
+            float rb_c = rb_1 * cb_1 + rb_2 * cb_2;
+
+            a.init_vx = a.init_vx - (2*b.size/(a.size + b.size)) * (r_c/(c_1 * c_1 + c_2 * c_2)) * c_1;
+            a.init_vy = a.init_vy - (2*b.size/(a.size + b.size)) * (r_c/(c_1 * c_1 + c_2 * c_2)) * c_2;
+            a.vx -= 0.01;
+            a.vy -= 0.01;
+
+            b.init_vx = b.init_vx - (2*a.size/(a.size + b.size)) * (rb_c/(cb_1 * cb_1 + cb_2 * cb_2)) * cb_1;
+            b.init_vy = b.init_vy - (2*a.size/(a.size + b.size)) * (rb_c/(cb_1 * cb_1 + cb_2 * cb_2)) * cb_2;
+            b.vx -= 0.01;
+            b.vy -= 0.01;
+
+        }
+
+        // Separate overlapping particles
+        float dist = std::sqrt(distSq);
+        float overlap = 0.5f * (minDist - dist + 1.0f);
+        float nx = dx / dist;
+        float ny = dy / dist;
+        a.x -= nx * overlap;
+        a.y -= ny * overlap;
+        b.x += nx * overlap;
+        b.y += ny * overlap;
+    }
+}
+
+void initParticles(World& w, size_t num, const SpeciesList& l) {
+    for (size_t i = 0; i < num; ++i) {
+        w.particles.push_back(makeRandomParticle(w, l));
+    }
+}
+
+double particleBytes(const std::vector<Particle>& particles) {
+    if (particles.empty()) return 0.0;
+    const size_t DEQUE_BLOCK = 512;
+    const size_t inlineName = std::string().capacity();
+    size_t bytes = particles.capacity() * sizeof(Particle);
+    for (const Particle& p : particles) {
+        if (p.name.capacity() > inlineName) bytes += p.name.capacity() + 1;
+        bytes += 8 * sizeof(void*) + (p.trail.size() / (DEQUE_BLOCK / sizeof(TrailPoint)) + 1) * DEQUE_BLOCK;
+    }
+    return static_cast<double>(bytes) / particles.size();
+}
+
+void updateTrail(const World& w, Particle& p) {
+    // Add to trail
+    float speed = std::sqrt(p.vx * p.vx + p.vy * p.vy);
+    p.trail.push_back({p.x, p.y, 1.0f});
+
+    // Lifespan proportional to speed
+    float longest = static_cast<float>(std::max<size_t>(w.maxTrail, 5));
+    size_t maxTrailLength = static_cast<size_t>(std::clamp(speed * 10.0f, 5.0f, longest));
+    while (p.trail.size() > maxTrailLength) {
+        p.trail.pop_front();
+    }
+
+    // Fade trail alpha
+    for (auto& pt : p.trail) {
+        pt.alpha *= 0.95f; // Fade out
+    }
+}
+
+void emitDecay(World& w, const Particle& p) {
+    w.decays++;
+    eventLog.decay(w.step, p.id, p.size);
+    w.spawned.push_back(makeRandomParticle(w, FUNDAMENTAL_PARTICLES));
+}
+
+void measureObservables(World& w) {
+    size_t n = w.particles.size();
+    size_t chunks = chunkCount(n);
+    size_t species = speciesCount();
+    if (w.partials.size() < chunks) w.partials.resize(chunks);
+
+    parallelFor(w.pool, n, [&](size_t begin, size_t end, size_t c) {
+        ObservablePartial& part = w.partials[c];
+        part.reset(species);
+        for (size_t i = begin; i < end; ++i) accumulate(part, w.particles[i]);
+    });
+    reduceObservables(w.partials, chunks, w.observables);
+    w.observables.step = w.step;
+}
+
+// The world temperature, or the field's local value when the temperature field is on
+static float localTemperature(const World& w, const Particle& p) {
+    if (!w.heat.enabled()) return w.temperature;
+    return std::max(w.temperature + w.heat.sample(p.x, p.y), 0.0f);
+}
+
+void wakeParticle(Particle& p) {
+    p.asleep = false;
+    p.still_steps = 0;
+}
+
+// A sleeper wakes once it would move at or above the sleep speed again
+static bool outgrewSleep(const World& w, const Particle& p) {
+    float scale = localTemperature(w, p) * (1.0f - w.friction);
+    float vx = p.init_vx * scale;
+    float vy = p.init_vy * scale;
+    return vx * vx + vy * vy >= w.sleep.speed * w.sleep.speed;
+}
+
+static void settleParticle(const World& w, Particle& p) {
+    if (p.vx * p.vx + p.vy * p.vy >= w.sleep.speed * w.sleep.speed) {
+        p.still_steps = 0;
+        return;
+    }
+    if (++p.still_steps < w.sleep.steps) return;
+    p.asleep = true;
+    p.vx = 0.0f;
+    p.vy = 0.0f;
+    p.trail.clear();
+}
+
+static void integrateParticle(const World& w, Particle& p) {
+    // Scale velocity with temperature, local when the temperature field is on
+    float temperature = localTemperature(w, p);
+    p.vx = p.init_vx * temperature;
+    p.vy = p.init_vy * temperature;
+    // Scale velocity with air resistance
+    p.vx *= (1.0f - w.friction);
+    p.vy *= (1.0f - w.friction);
+    p.x += p.vx;
+    p.y += p.vy;
+
+    updateTrail(w, p);
+
+    // Bounce off the window edges
+    if (p.x - p.size < 0.0f) {
+        p.x = p.size;
+        p.init_vx *= -1.0f;
+    }
+    if (p.x + p.size > WINDOW_WIDTH) {
+        p.x = WINDOW_WIDTH - p.size;
+        p.init_vx *= -1.0f;
+    }
+
+    // Check Y boundaries
+    if (p.y - p.size < 0.0f) {
+        p.y = p.size;
+        p.init_vy *= -1.0f;
+    }
+    if (p.y + p.size > WINDOW_HEIGHT) {
+        p.y = WINDOW_HEIGHT - p.size;
+        p.init_vy *= -1.0f;
+    }
+}
+
+// Drops the inputs of this step's merges, and their share of the observables
+static void removeConsumed(World& w, StepObservables& obs) {
+    const std::vector<uint8_t>& consumed = w.reactions.consumed;
+    ObservablePartial& gone = w.delta;
+    gone.reset(speciesCount());
+    size_t out = 0;
+    for (size_t i = 0; i < w.particles.size(); ++i) {
+        if (consumed[i]) {
+            accumulate(gone, w.particles[i]);
+            continue;
+        }
+        if (out != i) w.particles[out] = std::move(w.particles[i]);
+        out++;
+    }
+    w.particles.resize(out);
+    w.reactions.consumed.clear();
+
+    obs.particles -= gone.particles;
+    obs.kineticEnergy -= gone.kineticEnergy;
+    obs.momentumX -= gone.momentumX;
+    obs.momentumY -= gone.momentumY;
+    obs.trailPoints -= gone.trailPoints;
+    obs.asleep -= gone.asleep;
+    for (size_t s = 0; s < gone.population.size(); ++s) obs.population[s] -= gone.population[s];
+}
+
+void updateParticles(World& w) {
+    w.step++;
+    w.gridFresh = false;
+    w.heat.step(w.pool);
+    uint64_t mergesBefore = w.merges;
+    uint64_t allocationsBefore = heapAllocationCount.load(std::memory_order_relaxed);
+
+    // New conditions may speed sleepers up, so everyone settles again
+    bool wakeAll = !w.sleep.enabled || w.temperature != w.settledTemperature || w.friction != w.settledFriction ||
+                   w.edits != w.settledEdits;
+    w.settledTemperature = w.temperature;
+    w.settledFriction = w.friction;
+    w.settledEdits = w.edits;
+    StepObservables& obs = w.observables;
+    obs.step = w.step;
+
+    // Integration pass: per-particle work and observables, in fixed chunks
+    size_t n = w.particles.size();
+    size_t chunks = chunkCount(n);
+    size_t species = speciesCount();
+    if (w.partials.size() < chunks) w.partials.resize(chunks);
+    if (w.decayed.size() < chunks) w.decayed.resize(chunks);
+
+    parallelFor(w.pool, n, [&](size_t begin, size_t end, size_t c) {
+        ObservablePartial& part = w.partials[c];
+        std::vector<size_t>& decayed = w.decayed[c];
+        part.reset(species);
+        decayed.clear();
+        for (size_t i = begin; i < end; ++i) {
+            Particle& p = w.particles[i];
+            if (p.frozen) {
+                accumulate(part, p);
+                continue;
+            }
+            if (decayParticle(p)) {
+                part.decays++;
+                decayed.push_back(i);
+                wakeParticle(p);
+            }
+            if (p.asleep) {
+                if (!wakeAll && !outgrewSleep(w, p)) {
+                    accumulate(part, p);
+                    continue;
+                }
+                wakeParticle(p);
+            }
+            integrateParticle(w, p);
+            if (w.sleep.enabled) settleParticle(w, p);
+            accumulate(part, p);
+        }
+    });
+    reduceObservables(w.partials, chunks, obs);
+
+    // Decay products are drawn from the world RNG, so emit them serially in particle order
+    for (size_t c = 0; c < chunks; ++c) {
+        for (size_t i : w.decayed[c]) emitDecay(w, w.particles[i]);
+    }
+
+    // Check collisions between particles; sleepers never touch each other, so a settled scene has none
+    if (obs.asleep < obs.particles) findContacts(w, w.contacts);
+    else w.contacts.clear();
+    obs.collisions = w.contacts.size();
+    resolveContacts(w, w.contacts);
+    obs.merges = w.merges - mergesBefore;
+    if (!w.reactions.consumed.empty()) removeConsumed(w, obs);
+
+    // Add particles created by decays and reactions this step
+    ObservablePartial& born = w.delta;
+    born.reset(species);
+    for (auto& p : w.spawned) {
+        accumulate(born, p);
+        w.particles.push_back(std::move(p));
+    }
+    w.spawned.clear();
+    obs.particles += born.particles;
+    obs.kineticEnergy += born.kineticEnergy;
+    obs.momentumX += born.momentumX;
+    obs.momentumY += born.momentumY;
+    obs.trailPoints += born.trailPoints;
+    for (size_t s = 0; s < species; ++s) obs.population[s] += born.population[s];
+
+    w.arena.reset();
+    obs.allocations = heapAllocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+}
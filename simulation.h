@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "collision.h"
+#include "frame_arena.h"
+#include "observables.h"
+#include "temperature_field.h"
+
+class ThreadPool;
+
+const uint16_t UNKNOWN_SPECIES = 0xFFFF;
+
+struct TrailPoint {
+    float x, y;
+    float alpha; // Fades over time
+};
+
+struct Particle {
+    float x, y;
+    float vx, vy;         // Current velocity (scaled)
+    float init_vx, init_vy; // Original velocity
+    float size;
+    float r, g, b;
+    std::string name;
+    uint16_t species = UNKNOWN_SPECIES; // Index into the species table
+    uint32_t id = 0;      // Stable handle used by the event log
+    bool merged = false;
+    int decay_time = 0;      // Seconds between decays, 0 uses DEFAULT_DECAY_SECONDS
+    int decay_countdown = 0; // Steps until the next decay
+    bool frozen = false;     // Pinned: skips decay, motion, reactions and collision response
+    bool asleep = false;     // Settled: skips motion, trail and tests against other sleepers
+    uint32_t still_steps = 0; // Consecutive steps below the sleep speed
+    uint64_t born_step = 0;
+    uint32_t parents[2] = {0, 0}; // Ids of the reaction inputs, 0 when not a reaction product
+    uint16_t parent_species[2] = {UNKNOWN_SPECIES, UNKNOWN_SPECIES};
+    std::deque<TrailPoint> trail;
+
+    bool operator==(const Particle& other) const {
+        return name == other.name &&
+           std::fabs(x - other.x) < 0.0001f &&
+           std::fabs(y - other.y) < 0.0001f &&
+           std::fabs(vx - other.vx) < 0.0001f &&
+           std::fabs(vy - other.vy) < 0.0001f &&
+           std::fabs(size - other.size) < 0.0001f;
+    }
+};
+
+using SpeciesList = std::vector<std::pair<std::string, float>>;
+
+const int WINDOW_WIDTH = 1200;
+const int WINDOW_HEIGHT = 800;
+
+// Decay is driven by the step counter; the interactive loop runs at about 60 steps per second
+const int STEPS_PER_SECOND = 60;
+const int DEFAULT_DECAY_SECONDS = 5;
+const float DECAY_SIZE = 92.0f;
+
+extern const SpeciesList ELEMENT_TYPES;
+extern const SpeciesList FUNDAMENTAL_PARTICLES;
+
+// Particles slower than speed for steps consecutive steps fall asleep: they
+// stop moving, drop their trail and are not tested against each other. They
+// wake when an awake particle touches them, when their decay fires, when the
+// temperature, friction or an edit changes the world, or when their speed at
+// the local temperature exceeds the threshold again.
+struct SleepSettings {
+    bool enabled = false;
+    float speed = 0.05f;  // Pixels per step
+    uint32_t steps = 30;
+};
+
+// All state of one simulation. Independent worlds can be stepped concurrently.
+struct World {
+    std::vector<Particle> particles;
+    float temperature = 0.5f;
+    float friction = 0.0f;
+    TemperatureField heat;         // Local offsets from temperature; off until configured
+    SleepSettings sleep;
+    size_t maxTrail = 50;          // Upper bound of the speed-based trail length, at least 5
+    uint64_t step = 0;
+    uint32_t nextId = 1;
+    std::mt19937 rng;
+
+    uint64_t merges = 0;
+    uint64_t decays = 0;
+
+    ThreadPool* pool = nullptr;    // Runs the per-particle passes in parallel when set
+    StepObservables observables;   // Statistics of the last step
+
+    // Per-step scratch, kept across steps to avoid reallocating
+    std::vector<Particle> spawned; // Particles created during the current step
+    std::vector<ObservablePartial> partials;
+    std::vector<std::vector<size_t>> decayed;
+    ObservablePartial delta;       // Particles removed or added after the integration pass
+    FrameArena arena;              // Temporaries of one step, reset when the step ends
+    BroadPhase broadPhase = BroadPhase::Grid;
+    UniformGrid grid;              // Broad phase of the last step, reused by spatial queries
+    LooseQuadtree quadtree;        // Broad phase when broadPhase is Quadtree
+    bool gridFresh = false;        // grid matches the current positions
+    uint64_t edits = 0;            // Bumped by edits made outside the step functions
+    float settledTemperature = 0.0f; // Conditions the sleeping particles settled under
+    float settledFriction = 0.0f;
+    uint64_t settledEdits = 0;
+    std::vector<Contact> contacts;
+    std::vector<std::vector<Contact>> contactChunks;
+    ContactBatch batch;
+    ReactionScratch reactions;
+
+    explicit World(uint32_t seed = std::random_device{}()) : rng(seed) {}
+};
+
+// "element", "particle" or "both" (case-insensitive); returns false for anything else
+// Species ids are indices into a fixed table of every element, particle and reaction product
+uint16_t speciesId(const std::string& name);
+const std::string& speciesName(uint16_t id);
+size_t speciesCount();
+
+bool speciesForMode(const std::string& mode, SpeciesList& out);
+
+std::string reactionOutput(const Particle& a, const Particle& b);
+// Same lookup as reactionOutput on species ids; UNKNOWN_SPECIES when the pair does not react
+uint16_t reactionProduct(uint16_t a, uint16_t b);
+float minimumSeparation(const Particle& a, const Particle& b);
+bool isOverlapping(const Particle& newParticle, const std::vector<Particle>& particles);
+
+void generateParticle(World& w, const std::string& particle_name);
+// Radius listed for an element or fundamental particle, fallback for reaction products
+float speciesRadius(uint16_t species, float fallback);
+// Renames p to the species and takes its listed radius; particle id and motion are kept
+void setSpecies(Particle& p, uint16_t species);
+// Erases the particles at the given indices (any order, duplicates allowed), keeping the rest in order
+void removeParticles(World& w, const std::vector<uint32_t>& indices);
+// A white particle of the given species with a fresh id; size <= 0 uses the species' listed radius
+Particle makeParticle(World& w, uint16_t species, float x, float y, float vx, float vy, float size = 0.0f);
+// The product of a reacting with b, without touching the world, so products can be built in parallel
+Particle makeProduct(const Particle& a, const Particle& b, uint16_t species, uint32_t id, uint64_t step);
+// Counts, logs and heats a merge whose product was built by makeProduct
+void recordMerge(World& w, const Particle& a, const Particle& b, const Particle& product);
+// Queues the product in w.spawned; removing the inputs is up to the caller
+void mergeParticles(World& w, Particle& a, Particle& b, const std::string& new_name);
+void resolveCollision(World& w, Particle& a, Particle& b);
+void initParticles(World& w, size_t num, const SpeciesList& l);
+void updateParticles(World& w);
+// Approximate heap bytes per particle: the struct, its name when not stored
+// inline and its trail's deque map and blocks (libstdc++ layout)
+double particleBytes(const std::vector<Particle>& particles);
+
+// Building blocks of a step, shared with the event-driven engine
+// Heavy particles shed mass on a fixed step period. Returns true when the
+// particle decayed this step; the caller emits the fundamental particle.
+bool decayParticle(Particle& p);
+void emitDecay(World& w, const Particle& p);
+void updateTrail(const World& w, Particle& p);
+void wakeParticle(Particle& p);
+// Refills w.observables' per-particle statistics; event counts are left to the caller
+void measureObservables(World& w);
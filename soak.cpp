@@ -0,0 +1,257 @@
+// Long-running leak guard. Runs the headless simulation at fixed
+// configurations, samples process and world metrics every K steps and exits
+// non-zero when any of them grows past its threshold relative to the first
+// sample after warm-up.
+//
+//     ./particle_soak --mode=element --count=500 --duration=7200 --every=600
+//     ./particle_soak --config=soak.cfg --steps=200000 --csv=soak.csv
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "parallel.h"
+#include "simulation.h"
+#include "sweep.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+struct SoakOptions {
+    std::string configPath;        // Sweep-format config; empty runs the single config below
+    SweepConfig config;
+    uint64_t steps = 0;            // 0 = limited by duration only
+    double duration = 600.0;       // Wall-clock seconds per configuration, 0 = limited by steps only
+    uint64_t every = 500;          // Steps between samples
+    uint64_t warmup = 2;           // Samples before the baseline is taken
+    unsigned threads = 0;
+    std::string csvPath;
+
+    // Thresholds relative to the baseline sample
+    double maxRssGrowth = 1.5;
+    double maxHeapGrowth = 1.5;
+    long maxThreadGrowth = 0;
+    double maxParticleGrowth = 2.0;
+    double maxStepTimeGrowth = 3.0;
+};
+
+struct SoakSample {
+    uint64_t step = 0;
+    double seconds = 0.0;
+    size_t rss = 0;        // Resident set size in bytes, 0 when unavailable
+    size_t heap = 0;       // Bytes in use by malloc, 0 when unavailable
+    long threads = 0;      // Live threads in the process, 0 when unavailable
+    size_t particles = 0;
+    double stepMs = 0.0;   // Mean step time since the previous sample
+    double allocations = 0.0;  // Mean heap allocations per step since the previous sample
+};
+
+static size_t residentBytes() {
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (statm >> pages >> resident) return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    return 0;
+}
+
+static long liveThreads() {
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        if (key == "Threads:") {
+            long n = 0;
+            status >> n;
+            return n;
+        }
+        status.ignore(4096, '\n');
+    }
+#endif
+    return 0;
+}
+
+static size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// Growth of now over base; ignored (1.0) when the metric is unavailable
+static double growth(double now, double base) {
+    return base > 0.0 && now > 0.0 ? now / base : 1.0;
+}
+
+static bool parseSoakOptions(int argc, char** argv, SoakOptions& out) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            std::string key = arg.substr(0, eq);
+            std::string v = eq == std::string::npos ? "" : arg.substr(eq + 1);
+            if (key == "--config") out.configPath = v;
+            else if (key == "--mode") out.config.mode = v;
+            else if (key == "--count") out.config.count = std::stoul(v);
+            else if (key == "--temperature") out.config.temperature = std::stof(v);
+            else if (key == "--friction") out.config.friction = std::stof(v);
+            else if (key == "--seed") out.config.seed = static_cast<uint32_t>(std::stoul(v));
+            else if (key == "--steps") out.steps = std::stoull(v);
+            else if (key == "--duration") out.duration = std::stod(v);
+            else if (key == "--every") out.every = std::max<uint64_t>(1, std::stoull(v));
+            else if (key == "--warmup") out.warmup = std::stoull(v);
+            else if (key == "--threads") out.threads = static_cast<unsigned>(std::stoul(v));
+            else if (key == "--csv") out.csvPath = v;
+            else if (key == "--max-rss-growth") out.maxRssGrowth = std::stod(v);
+            else if (key == "--max-heap-growth") out.maxHeapGrowth = std::stod(v);
+            else if (key == "--max-thread-growth") out.maxThreadGrowth = std::stol(v);
+            else if (key == "--max-particle-growth") out.maxParticleGrowth = std::stod(v);
+            else if (key == "--max-step-time-growth") out.maxStepTimeGrowth = std::stod(v);
+            else {
+                std::cerr << "Usage: " << argv[0] << " [--config=<sweep config> | --mode=... --count=n --temperature=t"
+                             " --friction=f --seed=n]\n"
+                             "  [--steps=n] [--duration=<seconds>] [--every=k] [--warmup=samples] [--threads=n]"
+                             " [--csv=path]\n"
+                             "  [--max-rss-growth=x] [--max-heap-growth=x] [--max-thread-growth=n]"
+                             " [--max-particle-growth=x] [--max-step-time-growth=x]\n";
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid number in options\n";
+        return false;
+    }
+    if (out.steps == 0 && out.duration <= 0.0) {
+        std::cerr << "Either --steps or --duration must be set\n";
+        return false;
+    }
+    return true;
+}
+
+// Returns the names of the metrics over threshold, empty when the sample passes
+static std::string checkSample(const SoakOptions& o, const SoakSample& s, const SoakSample& base) {
+    std::string failed;
+    auto fail = [&](const char* metric, double value, double limit) {
+        char line[128];
+        snprintf(line, sizeof(line), "%s%s %.2f > %.2f", failed.empty() ? "" : ", ", metric, value, limit);
+        failed += line;
+    };
+    double rss = growth(s.rss, base.rss);
+    double heap = growth(s.heap, base.heap);
+    double particles = growth(s.particles, base.particles);
+    double stepTime = growth(s.stepMs, base.stepMs);
+    if (rss > o.maxRssGrowth) fail("rss", rss, o.maxRssGrowth);
+    if (heap > o.maxHeapGrowth) fail("heap", heap, o.maxHeapGrowth);
+    if (base.threads > 0 && s.threads - base.threads > o.maxThreadGrowth) {
+        fail("threads +", s.threads - base.threads, o.maxThreadGrowth);
+    }
+    if (particles > o.maxParticleGrowth) fail("particles", particles, o.maxParticleGrowth);
+    if (stepTime > o.maxStepTimeGrowth) fail("step time", stepTime, o.maxStepTimeGrowth);
+    return failed;
+}
+
+static bool soak(const SoakOptions& o, const SweepConfig& config, ThreadPool& pool, std::ofstream& csv) {
+    World w(config.seed);
+    w.temperature = config.temperature;
+    w.friction = config.friction;
+    w.pool = &pool;
+    SpeciesList species;
+    if (!speciesForMode(config.mode, species)) {
+        std::cerr << "Unknown mode: " << config.mode << "\n";
+        return false;
+    }
+    initParticles(w, config.count, species);
+
+    std::cout << "[soak] " << config.mode << " n=" << config.count << " T=" << config.temperature
+              << " f=" << config.friction << " seed=" << config.seed << "\n";
+    std::cout << "    step     time    rss MB   heap MB  threads  particles  step ms  allocs/step\n";
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    auto windowStart = start;
+    SoakSample base;
+    uint64_t samples = 0;
+    uint64_t allocations = 0;
+
+    while (true) {
+        updateParticles(w);
+        allocations += w.observables.allocations;
+        if (w.step % o.every != 0) continue;
+
+        auto now = clock::now();
+        SoakSample s;
+        s.step = w.step;
+        s.seconds = std::chrono::duration<double>(now - start).count();
+        s.rss = residentBytes();
+        s.heap = heapInUse();
+        s.threads = liveThreads();
+        s.particles = w.particles.size();
+        s.stepMs = std::chrono::duration<double, std::milli>(now - windowStart).count() / o.every;
+        s.allocations = static_cast<double>(allocations) / o.every;
+        windowStart = now;
+        allocations = 0;
+        samples++;
+
+        printf("%8llu %8.0f %9.1f %9.1f %8ld %10zu %8.3f %12.1f\n", static_cast<unsigned long long>(s.step),
+               s.seconds, s.rss / 1048576.0, s.heap / 1048576.0, s.threads, s.particles, s.stepMs, s.allocations);
+        fflush(stdout);
+        if (csv) {
+            csv << config.mode << ',' << config.count << ',' << config.temperature << ',' << config.friction << ','
+                << config.seed << ',' << s.step << ',' << s.seconds << ',' << s.rss << ',' << s.heap << ','
+                << s.threads << ',' << s.particles << ',' << s.stepMs << ',' << s.allocations << '\n';
+        }
+
+        if (samples == o.warmup + 1) base = s;
+        if (samples > o.warmup + 1) {
+            std::string failed = checkSample(o, s, base);
+            if (!failed.empty()) {
+                std::cout << "[soak] FAIL at step " << s.step << ": " << failed << "\n";
+                return false;
+            }
+        }
+
+        bool stepsDone = o.steps > 0 && w.step >= o.steps;
+        bool timeDone = o.duration > 0.0 && s.seconds >= o.duration;
+        if (stepsDone || timeDone) break;
+    }
+    std::cout << "[soak] pass\n";
+    return true;
+}
+
+int main(int argc, char** argv) {
+    SoakOptions options;
+    if (!parseSoakOptions(argc, argv, options)) return 2;
+
+    std::vector<SweepConfig> configs;
+    if (options.configPath.empty()) {
+        configs.push_back(options.config);
+    } else {
+        std::string error;
+        if (!loadSweepConfigs(options.configPath, configs, error)) {
+            std::cerr << "Soak config error: " << error << "\n";
+            return 2;
+        }
+    }
+
+    std::ofstream csv;
+    if (!options.csvPath.empty()) {
+        csv.open(options.csvPath);
+        csv << "mode,count,temperature,friction,seed,step,seconds,rss,heap,threads,particles,step_ms,allocations\n";
+    }
+
+    // One pool for all configurations, so its threads are part of every baseline
+    ThreadPool pool(options.threads);
+    bool passed = true;
+    for (const SweepConfig& config : configs) {
+        passed = soak(options, config, pool, csv) && passed;
+    }
+    return passed ? 0 : 1;
+}
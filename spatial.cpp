@@ -0,0 +1,105 @@
+#include "spatial.h"
+
+#include <algorithm>
+#include "simulation.h"
+
+void refreshSpatialIndex(World& w) {
+    if (w.gridFresh && w.grid.cellOf.size() == w.particles.size()) return;
+    w.grid.build(w.particles);
+    w.gridFresh = true;
+}
+
+// Calls fn(index) for every particle in the cells overlapping [x0, x1] x [y0, y1]
+template <typename Fn>
+static void forCells(const UniformGrid& grid, float x0, float y0, float x1, float y1, Fn&& fn) {
+    int cx0 = grid.cellX(x0), cx1 = grid.cellX(x1);
+    int cy0 = grid.cellY(y0), cy1 = grid.cellY(y1);
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            size_t cell = static_cast<size_t>(cy) * grid.cols + cx;
+            for (uint32_t k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; ++k) fn(grid.indices[k]);
+        }
+    }
+}
+
+void queryRadius(World& w, float x, float y, float radius, std::vector<uint32_t>& out) {
+    out.clear();
+    refreshSpatialIndex(w);
+    float r2 = radius * radius;
+    forCells(w.grid, x - radius, y - radius, x + radius, y + radius, [&](uint32_t i) {
+        float dx = w.particles[i].x - x;
+        float dy = w.particles[i].y - y;
+        if (dx * dx + dy * dy <= r2) out.push_back(i);
+    });
+    std::sort(out.begin(), out.end());
+}
+
+void queryRect(World& w, float x0, float y0, float x1, float y1, std::vector<uint32_t>& out) {
+    out.clear();
+    refreshSpatialIndex(w);
+    if (x1 < x0) std::swap(x0, x1);
+    if (y1 < y0) std::swap(y0, y1);
+    forCells(w.grid, x0, y0, x1, y1, [&](uint32_t i) {
+        const Particle& p = w.particles[i];
+        if (p.x >= x0 && p.x <= x1 && p.y >= y0 && p.y <= y1) out.push_back(i);
+    });
+    std::sort(out.begin(), out.end());
+}
+
+void queryNearest(World& w, float x, float y, size_t k, std::vector<uint32_t>& out) {
+    out.clear();
+    refreshSpatialIndex(w);
+    const UniformGrid& grid = w.grid;
+    k = std::min(k, w.particles.size());
+    if (k == 0) return;
+
+    // Search square rings of cells around the query cell. Everything outside
+    // ring r is at least r cells away, so stop once the k-th best is closer.
+    std::vector<std::pair<float, uint32_t>> found;
+    int cx = grid.cellX(x), cy = grid.cellY(y);
+    int maxRing = std::max({cx, cy, grid.cols - 1 - cx, grid.rows - 1 - cy});
+    for (int r = 0; r <= maxRing; ++r) {
+        for (int y0 = cy - r; y0 <= cy + r; ++y0) {
+            if (y0 < 0 || y0 >= grid.rows) continue;
+            // Interior rows of the ring only contribute their two end cells
+            int step = (y0 == cy - r || y0 == cy + r) ? 1 : std::max(2 * r, 1);
+            for (int x0 = cx - r; x0 <= cx + r; x0 += step) {
+                if (x0 < 0 || x0 >= grid.cols) continue;
+                size_t cell = static_cast<size_t>(y0) * grid.cols + x0;
+                for (uint32_t n = grid.cellStart[cell]; n < grid.cellStart[cell + 1]; ++n) {
+                    uint32_t i = grid.indices[n];
+                    float dx = w.particles[i].x - x;
+                    float dy = w.particles[i].y - y;
+                    found.push_back({dx * dx + dy * dy, i});
+                }
+            }
+        }
+        if (found.size() >= k) {
+            std::nth_element(found.begin(), found.begin() + (k - 1), found.end());
+            float bound = r * grid.cellSize;
+            if (found[k - 1].first <= bound * bound) break;
+        }
+    }
+
+    std::partial_sort(found.begin(), found.begin() + k, found.end());
+    for (size_t i = 0; i < k; ++i) out.push_back(found[i].second);
+}
+
+int64_t pickParticle(World& w, float x, float y) {
+    // A disc containing the point has its centre within the largest radius
+    refreshSpatialIndex(w);
+    float reach = w.grid.cellSize * 0.5f;
+    int64_t best = -1;
+    float bestDist = 0.0f;
+    forCells(w.grid, x - reach, y - reach, x + reach, y + reach, [&](uint32_t i) {
+        const Particle& p = w.particles[i];
+        float dx = p.x - x;
+        float dy = p.y - y;
+        float d2 = dx * dx + dy * dy;
+        if (d2 <= p.size * p.size && (best < 0 || d2 < bestDist)) {
+            best = i;
+            bestDist = d2;
+        }
+    });
+    return best;
+}
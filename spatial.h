@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct World;
+
+// Spatial queries over the world's particles, answered from the uniform grid
+// the collision pass builds. The grid is rebuilt on demand when particles have
+// moved since (see refreshSpatialIndex). Results are particle indices, valid
+// until the next step or edit of the particle list.
+
+// Rebuilds w.grid unless it already matches the current positions. Call after
+// editing positions or the particle list outside updateParticles, or clear
+// w.gridFresh.
+void refreshSpatialIndex(World& w);
+
+// Particles whose centre lies within radius of (x, y), in index order
+void queryRadius(World& w, float x, float y, float radius, std::vector<uint32_t>& out);
+
+// Particles whose centre lies inside the rectangle, in index order; corners may be given in any order
+void queryRect(World& w, float x0, float y0, float x1, float y1, std::vector<uint32_t>& out);
+
+// The k particles with the nearest centres, nearest first
+void queryNearest(World& w, float x, float y, size_t k, std::vector<uint32_t>& out);
+
+// Particle whose disc contains (x, y), the one with the nearest centre when
+// several overlap; -1 when the point is on no particle
+int64_t pickParticle(World& w, float x, float y);
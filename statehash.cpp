@@ -0,0 +1,192 @@
+#include "statehash.h"
+
+#include <cstring>
+#include <iostream>
+#include "parallel.h"
+#include "simulation.h"
+
+static const char TRACE_MAGIC[8] = {'P', 'S', 'H', 'A', 'S', 'H', '0', '1'};
+static const uint32_t TRACE_PER_PARTICLE = 1;
+
+// splitmix64 finaliser
+static inline uint64_t mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+static inline uint64_t combine(uint64_t h, uint64_t v) {
+    return mix(h ^ (v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+}
+
+static inline uint64_t bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+uint64_t hashParticle(const Particle& p) {
+    uint64_t h = p.id;
+    h = combine(h, bits(p.x) << 32 | bits(p.y));
+    h = combine(h, bits(p.vx) << 32 | bits(p.vy));
+    h = combine(h, bits(p.init_vx) << 32 | bits(p.init_vy));
+    h = combine(h, bits(p.size) << 32 | p.species);
+    h = combine(h, bits(p.r) << 32 | bits(p.g));
+    h = combine(h, bits(p.b) << 32 | static_cast<uint64_t>(p.merged));
+    h = combine(h, static_cast<uint64_t>(static_cast<uint32_t>(p.decay_time)) << 32 |
+                   static_cast<uint32_t>(p.decay_countdown));
+    h = combine(h, static_cast<uint64_t>(p.frozen) << 32 | static_cast<uint64_t>(p.parent_species[0]) << 16 |
+                   p.parent_species[1]);
+    h = combine(h, static_cast<uint64_t>(p.still_steps) << 1 | static_cast<uint64_t>(p.asleep));
+    h = combine(h, p.born_step);
+    h = combine(h, static_cast<uint64_t>(p.parents[0]) << 32 | p.parents[1]);
+    h = combine(h, p.trail.size());
+    for (const auto& pt : p.trail) {
+        h = combine(h, bits(pt.x) << 32 | bits(pt.y));
+        h = combine(h, bits(pt.alpha));
+    }
+    return h;
+}
+
+uint64_t hashState(World& w, std::vector<uint64_t>* perParticle) {
+    std::vector<uint64_t> local;
+    std::vector<uint64_t>& hashes = perParticle ? *perParticle : local;
+    hashes.resize(w.particles.size());
+
+    parallelFor(w.pool, w.particles.size(), [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) hashes[i] = hashParticle(w.particles[i]);
+    });
+
+    uint64_t h = combine(w.step, w.particles.size());
+    for (uint64_t v : hashes) h = combine(h, v);
+    return h;
+}
+
+HashTrace::~HashTrace() {
+    close();
+}
+
+bool HashTrace::open(const std::string& path, unsigned every, bool perParticle) {
+    close();
+    out_ = std::fopen(path.c_str(), "wb");
+    if (!out_) return false;
+    every_ = every > 0 ? every : 1;
+    perParticle_ = perParticle;
+    uint32_t flags = perParticle ? TRACE_PER_PARTICLE : 0;
+    std::fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), out_);
+    std::fwrite(&flags, sizeof(flags), 1, out_);
+    return true;
+}
+
+void HashTrace::close() {
+    if (out_) std::fclose(out_);
+    out_ = nullptr;
+}
+
+void HashTrace::record(World& w) {
+    if (!out_ || w.step % every_ != 0) return;
+
+    uint64_t h = hashState(w, &hashes_);
+    uint64_t count = w.particles.size();
+    std::fwrite(&w.step, sizeof(w.step), 1, out_);
+    std::fwrite(&count, sizeof(count), 1, out_);
+    std::fwrite(&h, sizeof(h), 1, out_);
+    if (perParticle_) {
+        for (size_t i = 0; i < count; ++i) {
+            std::fwrite(&w.particles[i].id, sizeof(uint32_t), 1, out_);
+            std::fwrite(&hashes_[i], sizeof(uint64_t), 1, out_);
+        }
+    }
+}
+
+namespace {
+
+struct TraceReader {
+    FILE* in = nullptr;
+    bool perParticle = false;
+
+    uint64_t step = 0, count = 0, hash = 0;
+    std::vector<uint32_t> ids;
+    std::vector<uint64_t> hashes;
+
+    ~TraceReader() { if (in) std::fclose(in); }
+
+    bool open(const std::string& path) {
+        in = std::fopen(path.c_str(), "rb");
+        if (!in) return false;
+        char magic[8];
+        uint32_t flags;
+        if (std::fread(magic, 1, 8, in) != 8 || std::memcmp(magic, TRACE_MAGIC, 8) != 0) return false;
+        if (std::fread(&flags, sizeof(flags), 1, in) != 1) return false;
+        perParticle = flags & TRACE_PER_PARTICLE;
+        return true;
+    }
+
+    bool next() {
+        if (std::fread(&step, sizeof(step), 1, in) != 1) return false;
+        if (std::fread(&count, sizeof(count), 1, in) != 1) return false;
+        if (std::fread(&hash, sizeof(hash), 1, in) != 1) return false;
+        if (perParticle) {
+            ids.resize(count);
+            hashes.resize(count);
+            for (uint64_t i = 0; i < count; ++i) {
+                if (std::fread(&ids[i], sizeof(uint32_t), 1, in) != 1) return false;
+                if (std::fread(&hashes[i], sizeof(uint64_t), 1, in) != 1) return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+int compareHashTraces(const std::string& pathA, const std::string& pathB) {
+    TraceReader a, b;
+    if (!a.open(pathA)) {
+        std::cerr << "Cannot read hash trace " << pathA << "\n";
+        return 2;
+    }
+    if (!b.open(pathB)) {
+        std::cerr << "Cannot read hash trace " << pathB << "\n";
+        return 2;
+    }
+
+    uint64_t compared = 0;
+    bool haveA = a.next(), haveB = b.next();
+    while (haveA && haveB) {
+        // Traces recorded with different intervals are compared on common steps only
+        if (a.step < b.step) { haveA = a.next(); continue; }
+        if (b.step < a.step) { haveB = b.next(); continue; }
+
+        if (a.hash != b.hash || a.count != b.count) {
+            std::cout << "Divergence at step " << a.step << ": " << a.count << " vs " << b.count << " particles\n";
+            if (a.perParticle && b.perParticle) {
+                uint64_t n = std::min(a.count, b.count);
+                for (uint64_t i = 0; i < n; ++i) {
+                    if (a.ids[i] != b.ids[i] || a.hashes[i] != b.hashes[i]) {
+                        std::cout << "First divergent particle: index " << i << " (id " << a.ids[i];
+                        if (a.ids[i] != b.ids[i]) std::cout << " vs " << b.ids[i];
+                        std::cout << ")\n";
+                        return 1;
+                    }
+                }
+                std::cout << "First " << n << " particles match; the particle lists differ in length\n";
+            } else {
+                std::cout << "Record both runs with --hash-particles to locate the particle\n";
+            }
+            return 1;
+        }
+
+        compared++;
+        haveA = a.next();
+        haveB = b.next();
+    }
+
+    std::cout << "Identical over " << compared << " recorded steps";
+    if (haveA || haveB) std::cout << " (" << (haveA ? pathA : pathB) << " continues further)";
+    std::cout << "\n";
+    return 0;
+}
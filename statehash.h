@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct Particle;
+struct World;
+
+// Bitwise state hashing for reproducibility checks. Every field of every
+// particle (trail included) is hashed by its exact bit pattern, then folded
+// in particle order, so any difference in any bit changes the state hash.
+
+uint64_t hashParticle(const Particle& p);
+
+// Per-particle hashes are computed on the world's pool; perParticle may be null
+uint64_t hashState(World& w, std::vector<uint64_t>* perParticle = nullptr);
+
+// Binary trace of state hashes: "PSHASH01", u32 flags, then per recorded step
+// u64 step, u64 count, u64 state hash and, with per-particle hashes enabled,
+// count * (u32 id, u64 hash).
+class HashTrace {
+public:
+    ~HashTrace();
+
+    bool open(const std::string& path, unsigned every = 1, bool perParticle = false);
+    void close();
+    bool isOpen() const { return out_ != nullptr; }
+
+    // Hashes the world if its step is a multiple of every
+    void record(World& w);
+
+private:
+    FILE* out_ = nullptr;
+    unsigned every_ = 1;
+    bool perParticle_ = false;
+    std::vector<uint64_t> hashes_;
+};
+
+// Compares two traces and prints the first divergent step (and particle,
+// when both traces carry per-particle hashes). Returns 0 when identical,
+// 1 on divergence and 2 when a trace cannot be read.
+int compareHashTraces(const std::string& a, const std::string& b);
@@ -0,0 +1,242 @@
+#include "sweep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "simulation.h"
+
+static std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return "";
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+static std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> items;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim(item);
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool loadSweepConfigs(const std::string& path, std::vector<SweepConfig>& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    SweepConfig defaults;
+    std::vector<float> temperatures, frictions;
+    std::vector<std::string> modes;
+    std::vector<size_t> counts;
+    std::vector<uint32_t> seeds;
+    bool grid = false;
+
+    std::string line;
+    int lineNo = 0;
+    try {
+        while (std::getline(in, line)) {
+            ++lineNo;
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty()) continue;
+
+            if (line.rfind("run", 0) == 0 && line.find('=') == std::string::npos) {
+                std::stringstream ss(line.substr(3));
+                SweepConfig c;
+                if (!(ss >> c.temperature >> c.friction >> c.mode >> c.count >> c.seed)) {
+                    error = path + ":" + std::to_string(lineNo) + ": expected 'run <temperature> <friction> <mode> <count> <seed>'";
+                    return false;
+                }
+                out.push_back(c);
+                continue;
+            }
+
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) {
+                error = path + ":" + std::to_string(lineNo) + ": expected 'key = values' or 'run ...'";
+                return false;
+            }
+            std::string key = trim(line.substr(0, eq));
+            std::vector<std::string> values = splitList(line.substr(eq + 1));
+            grid = true;
+            for (const auto& v : values) {
+                if (key == "temperature") temperatures.push_back(std::stof(v));
+                else if (key == "friction") frictions.push_back(std::stof(v));
+                else if (key == "mode") modes.push_back(v);
+                else if (key == "count") counts.push_back(std::stoul(v));
+                else if (key == "seed") seeds.push_back(static_cast<uint32_t>(std::stoul(v)));
+                else {
+                    error = path + ":" + std::to_string(lineNo) + ": unknown key '" + key + "'";
+                    return false;
+                }
+            }
+        }
+    } catch (const std::exception&) {
+        error = path + ":" + std::to_string(lineNo) + ": invalid number";
+        return false;
+    }
+
+    if (grid) {
+        if (temperatures.empty()) temperatures.push_back(defaults.temperature);
+        if (frictions.empty()) frictions.push_back(defaults.friction);
+        if (modes.empty()) modes.push_back(defaults.mode);
+        if (counts.empty()) counts.push_back(defaults.count);
+        if (seeds.empty()) seeds.push_back(defaults.seed);
+        for (float t : temperatures)
+            for (float f : frictions)
+                for (const auto& m : modes)
+                    for (size_t n : counts)
+                        for (uint32_t s : seeds)
+                            out.push_back({t, f, m, n, s});
+    }
+
+    SpeciesList species;
+    for (const auto& c : out) {
+        if (!speciesForMode(c.mode, species)) {
+            error = "unknown species mode '" + c.mode + "' (expected element, particle or both)";
+            return false;
+        }
+    }
+    if (out.empty()) {
+        error = path + ": no runs configured";
+        return false;
+    }
+    return true;
+}
+
+static SweepResult runOne(const SweepConfig& config, uint64_t steps) {
+    SweepResult r;
+    r.config = config;
+
+    World w(config.seed);
+    w.temperature = config.temperature;
+    w.friction = config.friction;
+    SpeciesList species;
+    speciesForMode(config.mode, species);
+    initParticles(w, config.count, species);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < steps; ++i) {
+        updateParticles(w);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    r.steps = steps;
+    r.seconds = std::chrono::duration<double>(end - begin).count();
+    r.finalCount = w.particles.size();
+    r.merges = w.merges;
+    r.decays = w.decays;
+    for (const auto& p : w.particles) {
+        r.species[p.name]++;
+    }
+    return r;
+}
+
+std::vector<SweepResult> runSweep(const std::vector<SweepConfig>& configs, uint64_t steps, unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<unsigned>(threads, configs.size());
+
+    std::vector<SweepResult> results(configs.size());
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < configs.size(); i = next++) {
+            results[i] = runOne(configs[i], steps);
+            size_t finished = ++done;
+            std::fprintf(stderr, "\r[sweep] %zu/%zu runs finished", finished, configs.size());
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+    std::fprintf(stderr, "\n");
+    return results;
+}
+
+static std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+bool writeSweepResults(const std::string& path, const std::vector<SweepResult>& results) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    if (json) {
+        out << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            out << "  {\"temperature\": " << r.config.temperature
+                << ", \"friction\": " << r.config.friction
+                << ", \"mode\": \"" << jsonEscape(r.config.mode) << "\""
+                << ", \"count\": " << r.config.count
+                << ", \"seed\": " << r.config.seed
+                << ", \"steps\": " << r.steps
+                << ", \"seconds\": " << r.seconds
+                << ", \"steps_per_second\": " << (r.seconds > 0 ? r.steps / r.seconds : 0.0)
+                << ", \"final_count\": " << r.finalCount
+                << ", \"merges\": " << r.merges
+                << ", \"decays\": " << r.decays
+                << ", \"species\": {";
+            bool first = true;
+            for (const auto& [name, n] : r.species) {
+                out << (first ? "" : ", ") << "\"" << jsonEscape(name) << "\": " << n;
+                first = false;
+            }
+            out << "}}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    } else {
+        // Species counts go in one quoted column as name=count pairs separated by ';'
+        out << "temperature,friction,mode,count,seed,steps,seconds,steps_per_second,final_count,merges,decays,species\n";
+        for (const auto& r : results) {
+            out << r.config.temperature << "," << r.config.friction << "," << r.config.mode << ","
+                << r.config.count << "," << r.config.seed << "," << r.steps << "," << r.seconds << ","
+                << (r.seconds > 0 ? r.steps / r.seconds : 0.0) << "," << r.finalCount << ","
+                << r.merges << "," << r.decays << ",\"";
+            bool first = true;
+            for (const auto& [name, n] : r.species) {
+                out << (first ? "" : ";") << name << "=" << n;
+                first = false;
+            }
+            out << "\"\n";
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+int runSweepCommand(const SweepOptions& options) {
+    std::vector<SweepConfig> configs;
+    std::string error;
+    if (!loadSweepConfigs(options.configPath, configs, error)) {
+        std::cerr << "Sweep config error: " << error << "\n";
+        return 1;
+    }
+
+    std::cerr << "[sweep] " << configs.size() << " runs, " << options.steps << " steps each\n";
+    auto results = runSweep(configs, options.steps, options.threads);
+
+    if (!writeSweepResults(options.outputPath, results)) {
+        std::cerr << "Failed to write " << options.outputPath << "\n";
+        return 1;
+    }
+    std::cerr << "[sweep] results written to " << options.outputPath << "\n";
+    return 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Headless parameter sweeps: many independent worlds, one per worker thread.
+
+struct SweepConfig {
+    float temperature = 0.5f;
+    float friction = 0.0f;
+    std::string mode = "element";  // element, particle or both
+    size_t count = 100;
+    uint32_t seed = 1;
+};
+
+struct SweepResult {
+    SweepConfig config;
+    uint64_t steps = 0;
+    double seconds = 0.0;
+    size_t finalCount = 0;
+    uint64_t merges = 0;
+    uint64_t decays = 0;
+    std::map<std::string, size_t> species;  // Final population per species name
+};
+
+struct SweepOptions {
+    std::string configPath;
+    std::string outputPath = "sweep_results.csv";  // .json writes JSON, anything else CSV
+    uint64_t steps = 1000;
+    unsigned threads = 0;  // 0 uses every hardware thread
+};
+
+// Config file format, one entry per line ('#' starts a comment):
+//   temperature = 0.25, 0.5, 1.0     grid axis; the sweep runs the cartesian product
+//   friction = 0, 0.1                of all axes, unset axes keep their defaults
+//   mode = element, both
+//   count = 100, 400
+//   seed = 1, 2, 3
+//   run 0.5 0.0 particle 200 7       one explicit run: temperature friction mode count seed
+bool loadSweepConfigs(const std::string& path, std::vector<SweepConfig>& out, std::string& error);
+
+std::vector<SweepResult> runSweep(const std::vector<SweepConfig>& configs, uint64_t steps, unsigned threads);
+
+bool writeSweepResults(const std::string& path, const std::vector<SweepResult>& results);
+
+// Entry point for --sweep; returns the process exit code
+int runSweepCommand(const SweepOptions& options);
@@ -0,0 +1,168 @@
+#include "temperature_field.h"
+
+#include <algorithm>
+#include <cmath>
+#include "parallel.h"
+#include "simulation.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PARTICLE_SIM_AVX2 1
+#include <immintrin.h>
+#endif
+
+// Rows diffused per pool task
+static const int FIELD_BAND = 16;
+
+void TemperatureField::configure(float cellSize) {
+    if (cellSize <= 0.0f) {
+        cols_ = rows_ = stride_ = 0;
+        cellSize_ = 0.0f;
+        cur_.clear();
+        next_.clear();
+        return;
+    }
+    cellSize_ = cellSize;
+    cols_ = std::max(1, static_cast<int>(std::ceil(WINDOW_WIDTH / cellSize)));
+    rows_ = std::max(1, static_cast<int>(std::ceil(WINDOW_HEIGHT / cellSize)));
+    stride_ = cols_ + 2;
+    cur_.assign(static_cast<size_t>(rows_ + 2) * stride_, 0.0f);
+    next_.assign(cur_.size(), 0.0f);
+}
+
+void TemperatureField::clear() {
+    std::fill(cur_.begin(), cur_.end(), 0.0f);
+}
+
+void TemperatureField::locate(float x, float y, int& x0, int& y0, float& tx, float& ty) const {
+    // max before min so a NaN position lands on the first cell instead of indexing out of range
+    float fx = std::min(std::max(0.0f, x / cellSize_ - 0.5f), static_cast<float>(cols_ - 1));
+    float fy = std::min(std::max(0.0f, y / cellSize_ - 0.5f), static_cast<float>(rows_ - 1));
+    x0 = std::min(static_cast<int>(fx), std::max(cols_ - 2, 0));
+    y0 = std::min(static_cast<int>(fy), std::max(rows_ - 2, 0));
+    tx = fx - x0;
+    ty = fy - y0;
+}
+
+float TemperatureField::sample(float x, float y) const {
+    if (!enabled()) return 0.0f;
+    int x0, y0;
+    float tx, ty;
+    locate(x, y, x0, y0, tx, ty);
+    // x0 + 1 and y0 + 1 are at most the halo, so no bounds checks are needed
+    const float* row0 = &cur_[index(x0, y0)];
+    const float* row1 = row0 + stride_;
+    float top = row0[0] + (row0[1] - row0[0]) * tx;
+    float bottom = row1[0] + (row1[1] - row1[0]) * tx;
+    return top + (bottom - top) * ty;
+}
+
+void TemperatureField::deposit(float x, float y, float amount) {
+    if (!enabled() || !std::isfinite(x) || !std::isfinite(y)) return;
+    int x0, y0;
+    float tx, ty;
+    locate(x, y, x0, y0, tx, ty);
+    int x1 = std::min(x0 + 1, cols_ - 1);
+    int y1 = std::min(y0 + 1, rows_ - 1);
+    cur_[index(x0, y0)] += amount * (1.0f - tx) * (1.0f - ty);
+    cur_[index(x1, y0)] += amount * tx * (1.0f - ty);
+    cur_[index(x0, y1)] += amount * (1.0f - tx) * ty;
+    cur_[index(x1, y1)] += amount * tx * ty;
+}
+
+void TemperatureField::paint(float x, float y, float radius, float amount) {
+    if (!enabled() || radius <= 0.0f) return;
+    int cx0 = std::max(0, static_cast<int>((x - radius) / cellSize_));
+    int cx1 = std::min(cols_ - 1, static_cast<int>((x + radius) / cellSize_));
+    int cy0 = std::max(0, static_cast<int>((y - radius) / cellSize_));
+    int cy1 = std::min(rows_ - 1, static_cast<int>((y + radius) / cellSize_));
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            float dx = (cx + 0.5f) * cellSize_ - x;
+            float dy = (cy + 0.5f) * cellSize_ - y;
+            float d = std::sqrt(dx * dx + dy * dy);
+            if (d < radius) cur_[index(cx, cy)] += amount * (1.0f - d / radius);
+        }
+    }
+}
+
+// Insulated edges: the halo mirrors the outermost cells, so no heat crosses them
+void TemperatureField::fillHalo() {
+    for (int cy = 0; cy < rows_; ++cy) {
+        float* row = &cur_[index(0, cy)];
+        row[-1] = row[0];
+        row[cols_] = row[cols_ - 1];
+    }
+    std::copy_n(&cur_[index(-1, 0)], stride_, &cur_[index(-1, -1)]);
+    std::copy_n(&cur_[index(-1, rows_ - 1)], stride_, &cur_[index(-1, rows_)]);
+}
+
+// out = (mid + k * ((left + right) + (up + down) - 4 * mid)) * keep
+static void diffuseRowScalar(const float* up, const float* mid, const float* down, float* out,
+                             int begin, int n, float k, float keep) {
+    for (int x = begin; x < n; ++x) {
+        float laplace = ((mid[x - 1] + mid[x + 1]) + (up[x] + down[x])) - 4.0f * mid[x];
+        out[x] = (mid[x] + k * laplace) * keep;
+    }
+}
+
+#ifdef PARTICLE_SIM_AVX2
+__attribute__((target("avx2")))
+static int diffuseRowAvx2(const float* up, const float* mid, const float* down, float* out,
+                          int n, float k, float keep) {
+    const __m256 vk = _mm256_set1_ps(k);
+    const __m256 vkeep = _mm256_set1_ps(keep);
+    const __m256 four = _mm256_set1_ps(4.0f);
+    int x = 0;
+    for (; x + 8 <= n; x += 8) {
+        __m256 centre = _mm256_loadu_ps(mid + x);
+        __m256 sides = _mm256_add_ps(_mm256_loadu_ps(mid + x - 1), _mm256_loadu_ps(mid + x + 1));
+        __m256 vertical = _mm256_add_ps(_mm256_loadu_ps(up + x), _mm256_loadu_ps(down + x));
+        __m256 laplace = _mm256_sub_ps(_mm256_add_ps(sides, vertical), _mm256_mul_ps(four, centre));
+        __m256 v = _mm256_mul_ps(_mm256_add_ps(centre, _mm256_mul_ps(vk, laplace)), vkeep);
+        _mm256_storeu_ps(out + x, v);
+    }
+    return x;
+}
+#endif
+
+void TemperatureField::step(ThreadPool* pool) {
+    if (!enabled()) return;
+    fillHalo();
+
+    float k = std::clamp(diffusion, 0.0f, 0.25f);
+    float keep = 1.0f - std::clamp(cooling, 0.0f, 1.0f);
+#ifdef PARTICLE_SIM_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    auto band = [&](size_t b) {
+        int end = std::min(rows_, static_cast<int>(b + 1) * FIELD_BAND);
+        for (int cy = static_cast<int>(b) * FIELD_BAND; cy < end; ++cy) {
+            const float* mid = &cur_[index(0, cy)];
+            float* out = &next_[index(0, cy)];
+            int done = 0;
+#ifdef PARTICLE_SIM_AVX2
+            if (avx2) done = diffuseRowAvx2(mid - stride_, mid, mid + stride_, out, cols_, k, keep);
+#endif
+            diffuseRowScalar(mid - stride_, mid, mid + stride_, out, done, cols_, k, keep);
+        }
+    };
+
+    size_t bands = static_cast<size_t>((rows_ + FIELD_BAND - 1) / FIELD_BAND);
+    if (!pool || pool->size() == 1 || bands <= 1) {
+        for (size_t b = 0; b < bands; ++b) band(b);
+    } else {
+        pool->run(bands, band);
+    }
+    cur_.swap(next_);
+}
+
+// Offset at which a cell reaches full tint
+static const float FIELD_TINT_RANGE = 0.5f;
+
+void temperatureTint(float v, uint8_t rgba[4]) {
+    bool warm = v > 0.0f;
+    rgba[0] = warm ? 255 : 40;
+    rgba[1] = warm ? 60 : 90;
+    rgba[2] = warm ? 30 : 255;
+    rgba[3] = static_cast<uint8_t>(std::min(std::fabs(v) / FIELD_TINT_RANGE, 1.0f) * 160.0f);
+}